@@ -0,0 +1,615 @@
+/*
+ * FbDbBench.cpp - end to end throughput and latency benchmarks against
+ *                 a scratch database, the results are written as JSON
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+#include "DbBlob.h"
+#include "DbConnection.h"
+#include "DbRowProxy.h"
+#include "DbStatement.h"
+#include "DbTransaction.h"
+#include "FbException.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+
+static char g_dbName[200] = "/tmp/DbWrap++FB_bench.fdb";
+static char g_dbServer[200] = "localhost";
+static char g_dbUserName[100] = "sysdba";
+static char DB_PASSWORD[32] = "masterkey";
+
+
+namespace fbbench
+{
+
+using namespace fb;
+
+typedef std::chrono::steady_clock Clock;
+
+static const char *g_server = g_dbServer;
+static unsigned int g_threads = 1;
+/** rows inserted by each insert benchmark */
+static unsigned int g_rows = 10000;
+/** bytes of the VARCHAR column of each row */
+static unsigned int g_payload = 100;
+/** bytes of each blob */
+static unsigned int g_blobSize = 1024 * 1024;
+static unsigned int g_blobs = 20;
+static unsigned int g_selects = 10000;
+static unsigned int g_transactions = 10000;
+static unsigned int g_events = 100;
+static const char *g_output = nullptr;
+
+/** volatile, keeps the compiler from dropping the reads */
+static volatile uint64_t g_sink = 0;
+
+struct Result
+{
+    std::string name_;
+    uint64_t ops_;
+    double seconds_;
+    /** bytes moved, 0 if it's not a throughput benchmark */
+    uint64_t bytes_;
+    /** per operation, empty if they weren't measured */
+    std::vector<uint64_t> latenciesNs_;
+};
+
+static uint64_t elapsedNs(Clock::time_point start)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - start).count());
+}
+
+static std::unique_ptr<DbConnection> connect()
+{
+    return std::unique_ptr<DbConnection>(new DbConnection(
+            g_dbName, g_server, g_dbUserName, DB_PASSWORD));
+}
+
+/** the database objects of a thread, destroyed in reverse order */
+struct Session
+{
+    std::unique_ptr<DbConnection> dbc_;
+    std::unique_ptr<DbTransaction> trans_;
+    std::unique_ptr<DbStatement> st_;
+};
+
+typedef std::shared_ptr<Session> SessionPtr;
+
+/** connect and start a transaction, sql is prepared if not null */
+static SessionPtr openSession(bool readOnly, const char *sql = nullptr)
+{
+    SessionPtr s(new Session);
+    s->dbc_ = connect();
+    s->trans_.reset(new DbTransaction(s->dbc_->nativeHandle(), 1,
+                                      DefaultTransMode::Commit,
+                                      readOnly ? TransStartMode::StartReadOnly :
+                                                 TransStartMode::StartReadWrite));
+    if (sql) {
+        s->st_.reset(new DbStatement(s->dbc_->createStatement(sql, s->trans_.get())));
+    }
+    return s;
+}
+
+/**
+ * run the work of g_threads threads, prepare(threadIndex) connects and
+ * returns the work to time, it's called on the thread itself. All the
+ * threads start working at once, the wall clock time is returned.
+ */
+static double runThreads(std::function<std::function<void()>(unsigned int)> prepare)
+{
+    std::promise<void> go;
+    std::shared_future<void> started(go.get_future());
+    std::atomic<unsigned int> ready(0);
+    std::vector<Clock::time_point> finished(g_threads);
+    std::vector<std::future<void>> threads;
+
+    for (unsigned int t = 0; t != g_threads; ++t) {
+        threads.push_back(std::async(std::launch::async,
+                [&prepare, &ready, &finished, started, t]() {
+            std::function<void()> work;
+            try {
+                work = prepare(t);
+            } catch (...) {
+                ++ready;
+                throw;
+            }
+            ++ready;
+            started.wait();
+            work();
+            // before the connections are closed
+            finished[t] = Clock::now();
+        }));
+    }
+
+    while (ready.load() != g_threads) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    Clock::time_point const start = Clock::now();
+    go.set_value();
+
+    for (auto &t : threads) {
+        // rethrows the failure of a thread
+        t.get();
+    }
+    Clock::time_point const end = *std::max_element(finished.begin(), finished.end());
+    return std::chrono::duration<double>(end - start).count();
+}
+
+/** the first id and the id count of thread t in [first, first + count) */
+static void idRange(uint64_t first, uint64_t count, unsigned int t,
+                    uint64_t &from, uint64_t &to)
+{
+    from = first + count * t / g_threads;
+    to = first + count * (t + 1) / g_threads;
+}
+
+static void create_database()
+{
+    if (access(g_dbName, F_OK) == 0) {
+        unlink(g_dbName);
+    }
+
+    // a scratch database, asynchronous writes
+    DbCreateOptions opts(8192, false);
+    DbConnection dbc(g_dbName, g_server, g_dbUserName, DB_PASSWORD, &opts);
+
+    // a remote database can't be removed, start over with empty tables
+    DbTransaction trans(dbc.nativeHandle(), 1);
+    for (const char *table : { "BENCH_ROWS", "BENCH_BLOBS" }) {
+        DbStatement st = dbc.createStatement(
+                "SELECT 1 FROM RDB$RELATIONS WHERE RDB$RELATION_NAME = ?", &trans);
+        st.setText(1, table);
+        if (st.uniqueResult()) {
+            dbc.executeUpdate((std::string("DROP TABLE ") + table).c_str(), &trans);
+            trans.commitRetain();
+        }
+    }
+
+    std::string sql = "CREATE TABLE BENCH_ROWS (ID BIGINT NOT NULL PRIMARY KEY, "
+                      "PAYLOAD VARCHAR(" + std::to_string(g_payload) + "))";
+    dbc.executeUpdate(sql.c_str(), &trans);
+    dbc.executeUpdate("CREATE TABLE BENCH_BLOBS (ID BIGINT NOT NULL PRIMARY KEY, "
+                      "DATA BLOB)", &trans);
+    trans.commit();
+}
+
+/** each row in its own transaction, the statement is prepared once */
+static Result insert_single_row()
+{
+    Result r = { "insert_single_row", g_rows, 0, 0, {} };
+    const std::string payload(g_payload, 's');
+
+    r.seconds_ = runThreads([&payload](unsigned int t) -> std::function<void()> {
+        // prepared statements outlive the transaction they were prepared in
+        SessionPtr s = openSession(false,
+                "INSERT INTO BENCH_ROWS (ID, PAYLOAD) VALUES (?, ?)");
+        s->trans_->commit();
+
+        return [s, &payload, t]() {
+            uint64_t from, to;
+            idRange(0, g_rows, t, from, to);
+            for (uint64_t id = from; id != to; ++id) {
+                s->trans_->start();
+                s->st_->setInt(1, static_cast<int64_t>(id));
+                s->st_->setText(2, payload.c_str(), static_cast<int>(payload.size()));
+                s->st_->execute();
+                s->trans_->commit();
+            }
+        };
+    });
+    return r;
+}
+
+/** one transaction per thread, prepared once, executed for each row */
+static Result insert_prepared()
+{
+    Result r = { "insert_prepared", g_rows, 0, 0, {} };
+    const std::string payload(g_payload, 'p');
+
+    r.seconds_ = runThreads([&payload](unsigned int t) -> std::function<void()> {
+        SessionPtr s = openSession(false);
+
+        return [s, &payload, t]() {
+            DbStatement st = s->dbc_->createStatement(
+                    "INSERT INTO BENCH_ROWS (ID, PAYLOAD) VALUES (?, ?)", s->trans_.get());
+            uint64_t from, to;
+            idRange(g_rows, g_rows, t, from, to);
+            for (uint64_t id = from; id != to; ++id) {
+                st.setInt(1, static_cast<int64_t>(id));
+                st.setText(2, payload.c_str(), static_cast<int>(payload.size()));
+                st.execute();
+            }
+            s->trans_->commit();
+        };
+    });
+    return r;
+}
+
+/** one transaction per thread, each row is an executeUpdate of SQL text */
+static Result insert_execute_update()
+{
+    Result r = { "insert_execute_update", g_rows, 0, 0, {} };
+    const std::string payload(g_payload, 'u');
+
+    r.seconds_ = runThreads([&payload](unsigned int t) -> std::function<void()> {
+        SessionPtr s = openSession(false);
+
+        return [s, &payload, t]() {
+            uint64_t from, to;
+            idRange(2 * static_cast<uint64_t>(g_rows), g_rows, t, from, to);
+            std::string sql;
+            for (uint64_t id = from; id != to; ++id) {
+                sql = "INSERT INTO BENCH_ROWS (ID, PAYLOAD) VALUES (" +
+                      std::to_string(id) + ", '" + payload + "')";
+                s->dbc_->executeUpdate(sql.c_str(), s->trans_.get());
+            }
+            s->trans_->commit();
+        };
+    });
+    return r;
+}
+
+/** primary key lookups of random rows with a prepared statement */
+static Result point_select()
+{
+    Result r = { "point_select", g_selects, 0, 0, {} };
+    std::vector<std::vector<uint64_t>> latencies(g_threads);
+    const uint64_t rowCount = 3 * static_cast<uint64_t>(g_rows);
+
+    r.seconds_ = runThreads([&latencies, rowCount](unsigned int t) -> std::function<void()> {
+        SessionPtr s = openSession(true, "SELECT PAYLOAD FROM BENCH_ROWS WHERE ID = ?");
+
+        std::vector<uint64_t> &lat = latencies[t];
+        uint64_t from, to;
+        idRange(0, g_selects, t, from, to);
+        lat.reserve(static_cast<size_t>(to - from));
+
+        return [s, &lat, from, to, rowCount]() {
+            DbStatement &st = *s->st_;
+            uint64_t id = from * 7919;
+            for (uint64_t i = from; i != to; ++i) {
+                id = (id * 6364136223846793005ULL + 1442695040888963407ULL);
+                Clock::time_point const start = Clock::now();
+                st.setInt(1, static_cast<int64_t>((id >> 33) % rowCount));
+                DbRowProxy row = st.uniqueResult();
+                if (row) {
+                    g_sink = g_sink + row.getText(0).size();
+                }
+                st.reset();
+                lat.push_back(elapsedNs(start));
+            }
+        };
+    });
+
+    for (const auto &lat : latencies) {
+        r.latenciesNs_.insert(r.latenciesNs_.end(), lat.begin(), lat.end());
+    }
+    return r;
+}
+
+/** every thread reads the whole table */
+static Result full_scan()
+{
+    Result r = { "full_scan", 0, 0, 0, {} };
+    std::atomic<uint64_t> rows(0);
+    std::atomic<uint64_t> bytes(0);
+
+    r.seconds_ = runThreads([&rows, &bytes](unsigned int) -> std::function<void()> {
+        SessionPtr s = openSession(true, "SELECT ID, PAYLOAD FROM BENCH_ROWS");
+        return [s, &rows, &bytes]() {
+            DbStatement &st = *s->st_;
+            uint64_t n = 0;
+            uint64_t b = 0;
+            for (auto it = st.iterate(); it != st.end(); ++it) {
+                DbRowProxy row = *it;
+                g_sink = g_sink + static_cast<uint64_t>(row.getInt64(0));
+                b += row.getText(1).size();
+                ++n;
+            }
+            rows += n;
+            bytes += b;
+        };
+    });
+
+    r.ops_ = rows.load();
+    r.bytes_ = bytes.load();
+    return r;
+}
+
+static Result blob_write()
+{
+    Result r = { "blob_write", g_blobs, 0,
+                 static_cast<uint64_t>(g_blobs) * g_blobSize, {} };
+    const std::string chunk(32 * 1024, 'b');
+
+    r.seconds_ = runThreads([&chunk](unsigned int t) -> std::function<void()> {
+        SessionPtr s = openSession(false, "INSERT INTO BENCH_BLOBS (ID, DATA) VALUES (?, ?)");
+        return [s, &chunk, t]() {
+            DbStatement &st = *s->st_;
+            uint64_t from, to;
+            idRange(0, g_blobs, t, from, to);
+            for (uint64_t id = from; id != to; ++id) {
+                DbBlob blob(*s->dbc_->nativeHandle(), *s->trans_->nativeHandle());
+                for (unsigned int left = g_blobSize; left != 0; ) {
+                    unsigned int n = std::min<unsigned int>(
+                            left, static_cast<unsigned int>(chunk.size()));
+                    blob.write(chunk.data(), static_cast<unsigned short>(n));
+                    left -= n;
+                }
+                blob.close();
+                st.setInt(1, static_cast<int64_t>(id));
+                st.setBlob(2, blob);
+                st.execute();
+            }
+            s->trans_->commit();
+        };
+    });
+    return r;
+}
+
+static Result blob_read()
+{
+    Result r = { "blob_read", 0, 0, 0, {} };
+    std::atomic<uint64_t> blobs(0);
+    std::atomic<uint64_t> bytes(0);
+
+    r.seconds_ = runThreads([&blobs, &bytes](unsigned int t) -> std::function<void()> {
+        SessionPtr s = openSession(true,
+                "SELECT DATA FROM BENCH_BLOBS WHERE ID >= ? AND ID < ?");
+        return [s, &blobs, &bytes, t]() {
+            DbStatement &st = *s->st_;
+            uint64_t from, to;
+            idRange(0, g_blobs, t, from, to);
+            st.setInt(1, static_cast<int64_t>(from));
+            st.setInt(2, static_cast<int64_t>(to));
+
+            std::vector<char> buffer(32 * 1024);
+            for (auto it = st.iterate(); it != st.end(); ++it) {
+                DbBlob blob = (*it).getBlob(0);
+                unsigned short n;
+                while ((n = blob.read(&buffer[0],
+                                      static_cast<unsigned short>(buffer.size()))) != 0) {
+                    bytes += n;
+                }
+                ++blobs;
+            }
+        };
+    });
+
+    r.ops_ = blobs.load();
+    r.bytes_ = bytes.load();
+    return r;
+}
+
+/** start and commit empty read-write transactions */
+static Result transaction_start_commit()
+{
+    Result r = { "transaction_start_commit", g_transactions, 0, 0, {} };
+    std::vector<std::vector<uint64_t>> latencies(g_threads);
+
+    r.seconds_ = runThreads([&latencies](unsigned int t) -> std::function<void()> {
+        std::shared_ptr<DbConnection> dbc(connect());
+        std::vector<uint64_t> &lat = latencies[t];
+        uint64_t from, to;
+        idRange(0, g_transactions, t, from, to);
+        lat.reserve(static_cast<size_t>(to - from));
+
+        return [dbc, &lat, from, to]() {
+            DbTransaction trans(dbc->nativeHandle(), 1, DefaultTransMode::Commit,
+                                TransStartMode::DeferStart);
+            for (uint64_t i = from; i != to; ++i) {
+                Clock::time_point const start = Clock::now();
+                trans.start();
+                trans.commit();
+                lat.push_back(elapsedNs(start));
+            }
+        };
+    });
+
+    for (const auto &lat : latencies) {
+        r.latenciesNs_.insert(r.latenciesNs_.end(), lat.begin(), lat.end());
+    }
+    return r;
+}
+
+struct EventWait
+{
+    std::mutex mutex_;
+    std::condition_variable delivered_;
+    int count_;
+};
+
+static void event_callback(void *data, const char *, int eventCount)
+{
+    EventWait *w = static_cast<EventWait*>(data);
+    {
+        std::lock_guard<std::mutex> const lg(w->mutex_);
+        w->count_ += eventCount;
+    }
+    w->delivered_.notify_all();
+}
+
+/** from the commit posting an event until its callback ran, single threaded */
+static Result event_latency()
+{
+    Result r = { "event_latency", 0, 0, 0, {} };
+    EventWait wait;
+    wait.count_ = 0;
+
+    std::unique_ptr<DbConnection> listener(connect());
+    std::unique_ptr<DbConnection> poster(connect());
+    listener->enableEvents(event_callback, &wait, { "DBWRAP_BENCH" });
+    // let the registration reach the server
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    Clock::time_point const begin = Clock::now();
+    for (unsigned int i = 0; i != g_events; ++i) {
+        DbTransaction trans(poster->nativeHandle(), 1);
+        poster->executeUpdate(
+                "EXECUTE BLOCK AS BEGIN POST_EVENT 'DBWRAP_BENCH'; END", &trans);
+
+        std::unique_lock<std::mutex> lk(wait.mutex_);
+        const int expected = wait.count_ + 1;
+        lk.unlock();
+
+        Clock::time_point const start = Clock::now();
+        trans.commit();
+        lk.lock();
+        if (!wait.delivered_.wait_for(lk, std::chrono::seconds(5),
+                                      [&wait, expected] { return wait.count_ >= expected; })) {
+            throw std::runtime_error("an event wasn't delivered within 5 seconds");
+        }
+        r.latenciesNs_.push_back(elapsedNs(start));
+    }
+    r.seconds_ = static_cast<double>(elapsedNs(begin)) / 1e9;
+    r.ops_ = g_events;
+
+    listener->disableEvents();
+    return r;
+}
+
+static double percentileUs(std::vector<uint64_t> &sorted, double q)
+{
+    size_t idx = static_cast<size_t>(q * static_cast<double>(sorted.size() - 1));
+    return static_cast<double>(sorted[idx]) / 1e3;
+}
+
+static void write_json(FILE *out, std::vector<Result> &results)
+{
+    fprintf(out, "{\n");
+    fprintf(out, "  \"library\": \"DbWrap++FB\",\n");
+    fprintf(out, "  \"server\": \"%s\",\n", g_server ? g_server : "embedded");
+    fprintf(out, "  \"threads\": %u,\n", g_threads);
+    fprintf(out, "  \"rows\": %u,\n", g_rows);
+    fprintf(out, "  \"payload_bytes\": %u,\n", g_payload);
+    fprintf(out, "  \"blob_bytes\": %u,\n", g_blobSize);
+    fprintf(out, "  \"results\": {");
+
+    for (size_t i = 0; i != results.size(); ++i) {
+        Result &r = results[i];
+        fprintf(out, "%s\n    \"%s\": {\n", i ? "," : "", r.name_.c_str());
+        fprintf(out, "      \"ops\": %llu,\n", static_cast<unsigned long long>(r.ops_));
+        fprintf(out, "      \"seconds\": %.6f,\n", r.seconds_);
+        fprintf(out, "      \"ops_per_second\": %.1f",
+                r.seconds_ > 0 ? static_cast<double>(r.ops_) / r.seconds_ : 0.0);
+        if (r.bytes_) {
+            fprintf(out, ",\n      \"mb_per_second\": %.2f",
+                    r.seconds_ > 0 ? static_cast<double>(r.bytes_) / 1048576.0 / r.seconds_ : 0.0);
+        }
+        if (!r.latenciesNs_.empty()) {
+            std::sort(r.latenciesNs_.begin(), r.latenciesNs_.end());
+            fprintf(out, ",\n      \"p50_us\": %.1f,\n      \"p99_us\": %.1f,\n"
+                         "      \"max_us\": %.1f",
+                    percentileUs(r.latenciesNs_, 0.5),
+                    percentileUs(r.latenciesNs_, 0.99),
+                    percentileUs(r.latenciesNs_, 1.0));
+        }
+        fprintf(out, "\n    }");
+    }
+    fprintf(out, "\n  }\n}\n");
+}
+
+static unsigned int positive(const char *arg)
+{
+    unsigned long n = strtoul(arg, nullptr, 10);
+    if (n == 0 || n > 1000000000ul) {
+        throw std::invalid_argument(std::string("invalid count: ") + arg);
+    }
+    return static_cast<unsigned int>(n);
+}
+
+} /* namespace fbbench */
+
+int main(int argc, char *argv[]) try
+{
+    using namespace fb;
+    using namespace fbbench;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = (i + 1) < argc;
+        if (strcmp(argv[i], "-server") == 0 && hasValue) {
+            snprintf(g_dbServer, sizeof(g_dbServer), "%s", argv[++i]);
+        } else if (strcmp(argv[i], "-embedded") == 0) {
+            g_server = nullptr;
+        } else if (strcmp(argv[i], "-name") == 0 && hasValue) {
+            snprintf(g_dbName, sizeof(g_dbName), "%s", argv[++i]);
+        } else if (strcmp(argv[i], "-user") == 0 && hasValue) {
+            snprintf(g_dbUserName, sizeof(g_dbUserName), "%s", argv[++i]);
+        } else if (strcmp(argv[i], "-password") == 0 && hasValue) {
+            snprintf(DB_PASSWORD, sizeof(DB_PASSWORD), "%s", argv[++i]);
+        } else if (strcmp(argv[i], "-threads") == 0 && hasValue) {
+            g_threads = positive(argv[++i]);
+        } else if (strcmp(argv[i], "-rows") == 0 && hasValue) {
+            g_rows = positive(argv[++i]);
+        } else if (strcmp(argv[i], "-payload") == 0 && hasValue) {
+            g_payload = std::min(positive(argv[++i]), 32000u);
+        } else if (strcmp(argv[i], "-blob") == 0 && hasValue) {
+            g_blobSize = positive(argv[++i]);
+        } else if (strcmp(argv[i], "-blobs") == 0 && hasValue) {
+            g_blobs = positive(argv[++i]);
+        } else if (strcmp(argv[i], "-selects") == 0 && hasValue) {
+            g_selects = positive(argv[++i]);
+        } else if (strcmp(argv[i], "-transactions") == 0 && hasValue) {
+            g_transactions = positive(argv[++i]);
+        } else if (strcmp(argv[i], "-events") == 0 && hasValue) {
+            g_events = positive(argv[++i]);
+        } else if (strcmp(argv[i], "-output") == 0 && hasValue) {
+            g_output = argv[++i];
+        } else {
+            printf("Unknown parameter: '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+
+    create_database();
+
+    std::vector<Result> results;
+    results.push_back(insert_single_row());
+    results.push_back(insert_prepared());
+    results.push_back(insert_execute_update());
+    results.push_back(point_select());
+    results.push_back(full_scan());
+    results.push_back(blob_write());
+    results.push_back(blob_read());
+    results.push_back(transaction_start_commit());
+    results.push_back(event_latency());
+
+    FILE *out = g_output ? fopen(g_output, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "can't open %s\n", g_output);
+        return 1;
+    }
+    write_json(out, results);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+} catch (std::exception &exc) {
+    fprintf(stderr, "benchmark failed:\n%s\n", exc.what());
+    return 1;
+}
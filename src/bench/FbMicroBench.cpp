@@ -0,0 +1,281 @@
+/*
+ * FbMicroBench.cpp - row decoding and parameter binding micro benchmarks,
+ *                    they run on synthetic rows and need no database
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+#include "DbRowProxy.h"
+#include "DbTimeStamp.h"
+#include "FbInternals.h"
+
+#include <ibase.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+// every heap allocation of the process is counted
+static uint64_t g_allocations = 0;
+
+void *operator new(size_t size)
+{
+    ++g_allocations;
+    void *p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    free(p);
+}
+
+namespace fbbench
+{
+
+using namespace fb;
+
+static unsigned int g_iterations = 1000000;
+
+/** keeps the compiler from dropping the benchmarked calls */
+static volatile uint64_t g_sink = 0;
+
+struct Column
+{
+    const char *name_;
+    short sqltype_;
+    short sqllen_;
+};
+
+/** a nullable column of each type that decodes without a server */
+static const Column COLUMNS[] = {
+    { "CHAR(20)", SQL_TEXT, 20 },
+    { "VARCHAR(40)", SQL_VARYING, 40 },
+    { "SMALLINT", SQL_SHORT, sizeof(ISC_SHORT) },
+    { "INTEGER", SQL_LONG, sizeof(ISC_LONG) },
+    { "BIGINT", SQL_INT64, sizeof(ISC_INT64) },
+    { "FLOAT", SQL_FLOAT, sizeof(float) },
+    { "DOUBLE PRECISION", SQL_DOUBLE, sizeof(double) },
+    { "TIMESTAMP", SQL_TIMESTAMP, sizeof(ISC_TIMESTAMP) },
+    { "DATE", SQL_TYPE_DATE, sizeof(ISC_DATE) },
+    { "TIME", SQL_TYPE_TIME, sizeof(ISC_TIME) },
+    { "BLOB", SQL_BLOB, sizeof(ISC_QUAD) },
+    { "NULL INTEGER", SQL_LONG, sizeof(ISC_LONG) },
+};
+static const int COLUMN_COUNT = static_cast<int>(sizeof(COLUMNS) / sizeof(COLUMNS[0]));
+static const int NULL_COLUMN = COLUMN_COUNT - 1;
+
+/** a row laid out by allocateAndSetXsqldaFields, as the statements do */
+class SyntheticRow
+{
+public:
+    SyntheticRow() : sqlda_(nullptr), fields_(nullptr)
+    {
+        sqlda_ = reinterpret_cast<SqlDescriptorArea*>(new char[XSQLDA_LENGTH(COLUMN_COUNT)]);
+        memset(sqlda_, 0, XSQLDA_LENGTH(COLUMN_COUNT));
+        sqlda_->version = SQLDA_VERSION1;
+        sqlda_->sqln = COLUMN_COUNT;
+        sqlda_->sqld = COLUMN_COUNT;
+        for (int i = 0; i != COLUMN_COUNT; ++i) {
+            XSQLVAR &v1 = sqlda_->sqlvar[i];
+            v1.sqltype = static_cast<short>(COLUMNS[i].sqltype_ | 1);
+            v1.sqllen = COLUMNS[i].sqllen_;
+        }
+        fields_ = allocateAndSetXsqldaFields(sqlda_);
+
+        setTextParameter(var(0), "Alice", 5);
+        setTextParameter(var(1), "alice@example.com", 17);
+        setIntParameter(var(2), 12345);
+        setIntParameter(var(3), 123456789);
+        setIntParameter(var(4), 1234567890123LL);
+        *reinterpret_cast<float*>(var(5).sqldata) = 3.25f;
+        *reinterpret_cast<double*>(var(6).sqldata) = 2.718281828;
+        ISC_TIMESTAMP *ts = reinterpret_cast<ISC_TIMESTAMP*>(var(7).sqldata);
+        ts->timestamp_date = 58000;
+        ts->timestamp_time = 45296789;
+        *reinterpret_cast<ISC_DATE*>(var(8).sqldata) = 58000;
+        *reinterpret_cast<ISC_TIME*>(var(9).sqldata) = 45296789;
+        ISC_QUAD *blobId = reinterpret_cast<ISC_QUAD*>(var(10).sqldata);
+        blobId->gds_quad_high = 1;
+        blobId->gds_quad_low = 2;
+        *var(NULL_COLUMN).sqlind = -1;
+    }
+
+    ~SyntheticRow()
+    {
+        delete [] fields_;
+        delete [] reinterpret_cast<char*>(sqlda_);
+    }
+
+    SqlDescriptorArea *sqlda()
+    {
+        return sqlda_;
+    }
+
+    XSQLVAR &var(int idx)
+    {
+        return sqlda_->sqlvar[idx];
+    }
+
+private:
+    SyntheticRow(const SyntheticRow&) = delete;
+    SyntheticRow &operator=(const SyntheticRow&) = delete;
+
+    SqlDescriptorArea *sqlda_;
+    unsigned char *fields_;
+};
+
+/** run op g_iterations times and print the cost of one call */
+template <typename Op>
+static void measure(const char *name, const char *column, Op op)
+{
+    // warm up the caches and the branch predictors
+    for (unsigned int i = 0; i != g_iterations / 10; ++i) {
+        op();
+    }
+
+    const uint64_t allocations = g_allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i != g_iterations; ++i) {
+        op();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    const uint64_t allocated = g_allocations - allocations;
+
+    double ns = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    printf("%-14s %-18s %10.1f ns/field %8.2f allocs/field\n", name, column,
+           ns / g_iterations, static_cast<double>(allocated) / g_iterations);
+}
+
+static void row_decoding_bench(SyntheticRow &r)
+{
+    const DbRowProxy row = makeRowProxy(r.sqlda());
+
+    for (unsigned int i = 0; i != static_cast<unsigned>(COLUMN_COUNT); ++i) {
+        measure("fieldIsNull", COLUMNS[i].name_, [&row, i]() {
+            g_sink = g_sink + row.fieldIsNull(i);
+        });
+    }
+
+    for (unsigned int i = 0; i != static_cast<unsigned>(COLUMN_COUNT); ++i) {
+        measure("getInt64", COLUMNS[i].name_, [&row, i]() {
+            g_sink = g_sink + static_cast<uint64_t>(row.getInt64(i));
+        });
+    }
+
+    for (unsigned int i = 0; i != static_cast<unsigned>(COLUMN_COUNT); ++i) {
+        if ((COLUMNS[i].sqltype_ & ~1) == SQL_BLOB) {
+            // reading the blob contents needs a server
+            continue;
+        }
+        measure("getText", COLUMNS[i].name_, [&row, i]() {
+            g_sink = g_sink + row.getText(i).size();
+        });
+    }
+}
+
+static void parameter_binding_bench(SyntheticRow &r)
+{
+    for (int i = 0; i != COLUMN_COUNT; ++i) {
+        const short type = COLUMNS[i].sqltype_;
+        XSQLVAR &v1 = r.var(i);
+        if (type == SQL_SHORT || type == SQL_LONG || type == SQL_INT64) {
+            int64_t n = 0;
+            measure("setInt", COLUMNS[i].name_, [&v1, &n]() {
+                setIntParameter(v1, ++n & 0x3FFF);
+            });
+        }
+    }
+
+    const char text[] = "The quick brown fox jumps over the lazy dog";
+    for (int i = 0; i != COLUMN_COUNT; ++i) {
+        const short type = COLUMNS[i].sqltype_;
+        XSQLVAR &v1 = r.var(i);
+        if (type == SQL_TEXT || type == SQL_VARYING) {
+            measure("setText", COLUMNS[i].name_, [&v1, &text]() {
+                setTextParameter(v1, text, strlen(text));
+            });
+        }
+    }
+}
+
+static void timestamp_bench()
+{
+    DbTimeStamp::IscTimestamp its;
+    its.isc_date_ = 58000;
+    its.isc_time_ = 45296789;
+    const DbTimeStamp ts(its);
+
+    measure("iso8601", "TIMESTAMP", [&ts]() {
+        g_sink = g_sink + ts.iso8601DateTime().size();
+    });
+}
+
+} /* namespace fbbench */
+
+int main(int argc, char *argv[]) try
+{
+    using namespace fbbench;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-iterations") == 0 && (i + 1) < argc) {
+            g_iterations = static_cast<unsigned int>(strtoul(argv[i + 1], nullptr, 10));
+            ++i;
+        } else {
+            printf("Unknown parameter: '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+    if (g_iterations == 0) {
+        printf("The iteration count must be positive.\n");
+        return 1;
+    }
+
+    printf("%u iterations per field\n", g_iterations);
+    SyntheticRow row;
+    row_decoding_bench(row);
+    // the decoding benchmarks read the values written here, bind last
+    parameter_binding_bench(row);
+    timestamp_bench();
+    return 0;
+} catch (std::exception &e) {
+    printf("Benchmark failed: %s\n", e.what());
+    return 1;
+}
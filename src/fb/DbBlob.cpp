@@ -15,7 +15,9 @@
 
 #include "DbBlob.h"
 #include <ibase.h>
+#include "DbProbes.h"
 #include "FbException.h"
+#include "FbInternals.h"
 #include <limits.h>
 
 namespace fb
@@ -103,6 +105,7 @@ unsigned short DbBlob::read(char *buffer, unsigned short size)
         throw std::logic_error("Can't read from blob opened for writing!");
     }
 
+    ScopedLatency const timer(DbOperation::BlobRead);
     ISC_STATUS_ARRAY status;
     unsigned short bytesRead = 0;
 
@@ -111,6 +114,7 @@ unsigned short DbBlob::read(char *buffer, unsigned short size)
                             &blob_handle_,
                             &bytesRead, size,
                             buffer);
+    DBWRAP_PROBE3(blob__read, blob_handle_, bytesRead, res);
 
     if (res == isc_segstr_eof) {
         return 0;
@@ -133,6 +137,7 @@ std::string DbBlob::readAll(unsigned int limit) const
         throw std::logic_error("Can't read from blob opened for writing!");
     }
 
+    ScopedLatency const timer(DbOperation::BlobRead);
     while (true) {
         ISC_STATUS_ARRAY status;
         unsigned short bytesRead = 0;
@@ -144,6 +149,7 @@ std::string DbBlob::readAll(unsigned int limit) const
                                 const_cast<FbApiHandle*>(&blob_handle_),
                                 &bytesRead, BUF_SIZE,
                                 buffer);
+        DBWRAP_PROBE3(blob__read, blob_handle_, bytesRead, res);
 
         if (res == isc_segstr_eof) {
             break;
@@ -172,8 +178,11 @@ bool DbBlob::write(const char *buffer, unsigned short size)
         throw std::logic_error("Can't write to blob opened for reading!");
     }
 
+    ScopedLatency const timer(DbOperation::BlobWrite);
     ISC_STATUS_ARRAY status;
-    if (isc_put_segment(status, &blob_handle_, size, buffer)) {
+    ISC_STATUS res = isc_put_segment(status, &blob_handle_, size, buffer);
+    DBWRAP_PROBE3(blob__write, blob_handle_, size, res);
+    if (res) {
         throw FbException("Failed to write to blob!", status);
     }
     return true;
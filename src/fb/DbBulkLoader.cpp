@@ -0,0 +1,1349 @@
+/*
+ * DbBulkLoader.cpp - load large delimited (CSV, TSV) files into a table
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbBulkLoader.h"
+
+#include "DbConnection.h"
+#include "DbStatement.h"
+#include "DbTransaction.h"
+#include "FbException.h"
+#include "FbInternals.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace fb
+{
+
+namespace {
+
+/** a read-only memory mapping of a whole file */
+class MappedFile
+{
+public:
+    explicit MappedFile(const char *fileName) : fd_(-1), data_(nullptr), size_(0)
+    {
+        fd_ = open(fileName, O_RDONLY);
+        if (fd_ < 0) {
+            throw std::runtime_error(std::string("Failed to open ") +
+                                     fileName + ": " + strerror(errno));
+        }
+
+        struct stat st;
+        if (fstat(fd_, &st) != 0) {
+            int err = errno;
+            close(fd_);
+            throw std::runtime_error(std::string("Failed to stat ") +
+                                     fileName + ": " + strerror(err));
+        }
+
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ == 0) {
+            return;
+        }
+
+        void *p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (p == MAP_FAILED) {
+            int err = errno;
+            close(fd_);
+            throw std::runtime_error(std::string("Failed to map ") +
+                                     fileName + ": " + strerror(err));
+        }
+        data_ = static_cast<const char*>(p);
+        madvise(p, size_, MADV_SEQUENTIAL);
+    }
+
+    ~MappedFile()
+    {
+        if (data_) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+        close(fd_);
+    }
+
+    const char *begin() const { return data_; }
+    const char *end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+
+    int fd_;
+    const char *data_;
+    size_t size_;
+};
+
+/** a field of an input line, quoted fields point into a scratch buffer */
+struct Field
+{
+    const char *data_;
+    size_t length_;
+    bool quoted_;
+};
+
+/** a line of the input file, without its end of line */
+struct LineRef
+{
+    const char *data_;
+    size_t length_;
+};
+
+/**
+ * split the line [p, e) into fields, quoted fields are unquoted into
+ * scratch which must not be reallocated while fields are used
+ * \return false if a quoted field is malformed
+ */
+static bool splitLine(const char *p, const char *e, char delimiter,
+                      std::vector<Field> &fields, std::string &scratch)
+{
+    fields.clear();
+    scratch.clear();
+    scratch.reserve(static_cast<size_t>(e - p));
+
+    while (true) {
+        Field f = { p, 0, false };
+        if (p != e && *p == '"') {
+            const size_t at = scratch.size();
+            ++p;
+            while (true) {
+                if (p == e) {
+                    // unterminated quoted field
+                    return false;
+                }
+                if (*p == '"') {
+                    if (p + 1 != e && p[1] == '"') {
+                        scratch += '"';
+                        p += 2;
+                        continue;
+                    }
+                    ++p;
+                    break;
+                }
+                scratch += *p++;
+            }
+
+            if (p != e && *p != delimiter) {
+                return false;
+            }
+            f.data_ = scratch.data() + at;
+            f.length_ = scratch.size() - at;
+            f.quoted_ = true;
+        } else {
+            const char *q = p;
+            while (q != e && *q != delimiter) {
+                ++q;
+            }
+            f.length_ = static_cast<size_t>(q - p);
+            p = q;
+        }
+
+        fields.push_back(f);
+        if (p == e) {
+            return true;
+        }
+        ++p; // the delimiter
+    }
+}
+
+static void trimSpaces(const char *&p, const char *&e)
+{
+    while (p != e && *p == ' ') {
+        ++p;
+    }
+    while (e != p && e[-1] == ' ') {
+        --e;
+    }
+}
+
+/**
+ * parse a decimal number into an integer scaled by 10^-scale,
+ * digits that don't fit the scale must be zero
+ */
+static bool parseScaledInt(const char *p, const char *e, int scale, int64_t &out)
+{
+    trimSpaces(p, e);
+    bool negative = false;
+    if (p != e && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    const uint64_t limit = negative ? (uint64_t(1) << 63) : (uint64_t(1) << 63) - 1;
+    const int fractionDigits = -std::min(scale, 0);
+    uint64_t v = 0;
+    int fraction = -1;
+    bool digits = false;
+
+    for (; p != e; ++p) {
+        if (*p == '.' && fraction < 0) {
+            fraction = 0;
+            continue;
+        }
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        digits = true;
+        if (fraction >= fractionDigits) {
+            if (*p != '0') {
+                return false;
+            }
+            continue;
+        }
+        const unsigned int d = static_cast<unsigned int>(*p - '0');
+        if (v > (limit - d) / 10) {
+            return false;
+        }
+        v = v * 10 + d;
+        if (fraction >= 0) {
+            ++fraction;
+        }
+    }
+
+    if (!digits) {
+        return false;
+    }
+
+    for (int i = std::max(fraction, 0); i < fractionDigits; ++i) {
+        if (v > limit / 10) {
+            return false;
+        }
+        v *= 10;
+    }
+
+    out = (negative && v) ? -static_cast<int64_t>(v - 1) - 1
+                          : static_cast<int64_t>(v);
+    return true;
+}
+
+static bool parseDouble(const char *p, const char *e, double &out)
+{
+    trimSpaces(p, e);
+    char buffer[64];
+    const size_t length = static_cast<size_t>(e - p);
+    if (length == 0 || length >= sizeof(buffer)) {
+        return false;
+    }
+    memcpy(buffer, p, length);
+    buffer[length] = '\0';
+
+    char *end = nullptr;
+    out = strtod(buffer, &end);
+    return end == buffer + length;
+}
+
+static bool parseNumber(const char *&p, const char *e, int digits, int &out)
+{
+    if (e - p < digits) {
+        return false;
+    }
+    out = 0;
+    for (int i = 0; i != digits; ++i, ++p) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        out = out * 10 + (*p - '0');
+    }
+    return true;
+}
+
+/** "YYYY-MM-DD" */
+static bool parseDate(const char *&p, const char *e, struct tm &t)
+{
+    int year, month, day;
+    if (!parseNumber(p, e, 4, year) || p == e || *p++ != '-' ||
+        !parseNumber(p, e, 2, month) || p == e || *p++ != '-' ||
+        !parseNumber(p, e, 2, day)) {
+        return false;
+    }
+
+    if (month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    t.tm_year = year - 1900;
+    t.tm_mon = month - 1;
+    t.tm_mday = day;
+    return true;
+}
+
+/** "HH:MM[:SS[.ffff]]", fraction receives 1/10000 of seconds */
+static bool parseTime(const char *&p, const char *e, struct tm &t,
+                      ISC_TIME &fraction)
+{
+    int hour, minute, second = 0;
+    if (!parseNumber(p, e, 2, hour) || p == e || *p++ != ':' ||
+        !parseNumber(p, e, 2, minute)) {
+        return false;
+    }
+
+    fraction = 0;
+    if (p != e && *p == ':') {
+        ++p;
+        if (!parseNumber(p, e, 2, second)) {
+            return false;
+        }
+        if (p != e && *p == '.') {
+            ++p;
+            ISC_TIME scale = 1000;
+            for (; p != e && *p >= '0' && *p <= '9'; ++p) {
+                fraction += static_cast<ISC_TIME>(*p - '0') * scale;
+                scale /= 10;
+            }
+        }
+    }
+
+    if (hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
+    t.tm_hour = hour;
+    t.tm_min = minute;
+    t.tm_sec = second;
+    return true;
+}
+
+static bool isSupportedType(const XSQLVAR &v1)
+{
+    switch (v1.sqltype & ~1) {
+    case SQL_TEXT:
+    case SQL_VARYING:
+    case SQL_SHORT:
+    case SQL_LONG:
+    case SQL_INT64:
+    case SQL_FLOAT:
+    case SQL_DOUBLE:
+    case SQL_D_FLOAT:
+    case SQL_TIMESTAMP:
+    case SQL_TYPE_DATE:
+    case SQL_TYPE_TIME:
+#ifdef SQL_BOOLEAN
+    case SQL_BOOLEAN:
+#endif
+        return true;
+    default:
+        return false;
+    }
+}
+
+/** convert a text field to the type of v1, false if it isn't a valid value */
+static bool convertField(XSQLVAR &v1, const Field &f)
+{
+    if (f.length_ == 0 && !f.quoted_) {
+        if ((v1.sqltype & 1) == 0) {
+            // the column doesn't take nulls
+            return false;
+        }
+        *v1.sqlind = -1;
+        return true;
+    }
+
+    if (v1.sqltype & 1) {
+        *v1.sqlind = 0;
+    }
+
+    const char *p = f.data_;
+    const char *e = f.data_ + f.length_;
+    int64_t i64;
+    double d;
+    struct tm t;
+    ISC_TIME fraction;
+
+    switch (v1.sqltype & ~1) {
+    case SQL_TEXT:
+        if (f.length_ > static_cast<size_t>(v1.sqllen)) {
+            return false;
+        }
+        memcpy(v1.sqldata, p, f.length_);
+        memset(v1.sqldata + f.length_, ' ',
+               static_cast<size_t>(v1.sqllen) - f.length_);
+        return true;
+    case SQL_VARYING: {
+        // the sqllen of VARYING fields includes the length prefix
+        FbVarchar *vc = reinterpret_cast<FbVarchar*>(v1.sqldata);
+        if (f.length_ > static_cast<size_t>(v1.sqllen - 2)) {
+            return false;
+        }
+        vc->length = static_cast<ISC_SHORT>(f.length_);
+        memcpy(vc->str, p, f.length_);
+        return true;
+    }
+    case SQL_SHORT:
+        if (!parseScaledInt(p, e, v1.sqlscale, i64) ||
+            i64 < INT16_MIN || i64 > INT16_MAX) {
+            return false;
+        }
+        *reinterpret_cast<ISC_SHORT*>(v1.sqldata) = static_cast<ISC_SHORT>(i64);
+        return true;
+    case SQL_LONG:
+        if (!parseScaledInt(p, e, v1.sqlscale, i64) ||
+            i64 < INT32_MIN || i64 > INT32_MAX) {
+            return false;
+        }
+        *reinterpret_cast<ISC_LONG*>(v1.sqldata) = static_cast<ISC_LONG>(i64);
+        return true;
+    case SQL_INT64:
+        if (!parseScaledInt(p, e, v1.sqlscale, i64)) {
+            return false;
+        }
+        *reinterpret_cast<ISC_INT64*>(v1.sqldata) = i64;
+        return true;
+    case SQL_FLOAT:
+        if (!parseDouble(p, e, d)) {
+            return false;
+        }
+        *reinterpret_cast<float*>(v1.sqldata) = static_cast<float>(d);
+        return true;
+    case SQL_DOUBLE:
+    case SQL_D_FLOAT:
+        if (!parseDouble(p, e, d)) {
+            return false;
+        }
+        *reinterpret_cast<double*>(v1.sqldata) = d;
+        return true;
+    case SQL_TYPE_DATE:
+        memset(&t, 0, sizeof(t));
+        if (!parseDate(p, e, t) || p != e) {
+            return false;
+        }
+        isc_encode_sql_date(&t, reinterpret_cast<ISC_DATE*>(v1.sqldata));
+        return true;
+    case SQL_TYPE_TIME:
+        memset(&t, 0, sizeof(t));
+        if (!parseTime(p, e, t, fraction) || p != e) {
+            return false;
+        }
+        isc_encode_sql_time(&t, reinterpret_cast<ISC_TIME*>(v1.sqldata));
+        *reinterpret_cast<ISC_TIME*>(v1.sqldata) += fraction;
+        return true;
+    case SQL_TIMESTAMP: {
+        memset(&t, 0, sizeof(t));
+        fraction = 0;
+        if (!parseDate(p, e, t)) {
+            return false;
+        }
+        if (p != e && (*p == ' ' || *p == 'T') &&
+            !parseTime(++p, e, t, fraction)) {
+            return false;
+        }
+        if (p != e) {
+            return false;
+        }
+        ISC_TIMESTAMP *ts = reinterpret_cast<ISC_TIMESTAMP*>(v1.sqldata);
+        isc_encode_timestamp(&t, ts);
+        ts->timestamp_time += fraction;
+        return true;
+    }
+#ifdef SQL_BOOLEAN
+    case SQL_BOOLEAN:
+        trimSpaces(p, e);
+        if ((e - p == 4 && strncasecmp(p, "true", 4) == 0) ||
+            (e - p == 1 && *p == '1')) {
+            *reinterpret_cast<unsigned char*>(v1.sqldata) = 1;
+        } else if ((e - p == 5 && strncasecmp(p, "false", 5) == 0) ||
+                   (e - p == 1 && *p == '0')) {
+            *reinterpret_cast<unsigned char*>(v1.sqldata) = 0;
+        } else {
+            return false;
+        }
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+/** width of a column of the external file holding values of v1 as text */
+static unsigned int externalWidth(const XSQLVAR &v1)
+{
+    switch (v1.sqltype & ~1) {
+    case SQL_TEXT:
+        return static_cast<unsigned int>(v1.sqllen);
+    case SQL_VARYING:
+        return static_cast<unsigned int>(v1.sqllen - 2);
+    case SQL_SHORT:
+        return 7;
+    case SQL_LONG:
+        return 12;
+    case SQL_INT64:
+        return 21;
+    case SQL_FLOAT:
+    case SQL_DOUBLE:
+    case SQL_D_FLOAT:
+        return 25;
+    case SQL_TYPE_DATE:
+        return 10;
+    case SQL_TYPE_TIME:
+        return 13;
+    case SQL_TIMESTAMP:
+        return 24;
+    default:
+        // boolean
+        return 5;
+    }
+}
+
+/** write the converted (not null) value of v1 as text into out */
+static size_t formatField(const XSQLVAR &v1, char *out, size_t size)
+{
+    struct tm t;
+    int n = 0;
+    ISC_TIME time;
+    const ISC_TIMESTAMP *ts;
+    const FbVarchar *vc;
+
+    switch (v1.sqltype & ~1) {
+    case SQL_TEXT:
+        memcpy(out, v1.sqldata, static_cast<size_t>(v1.sqllen));
+        return static_cast<size_t>(v1.sqllen);
+    case SQL_VARYING:
+        vc = reinterpret_cast<const FbVarchar*>(v1.sqldata);
+        memcpy(out, vc->str, static_cast<size_t>(vc->length));
+        return static_cast<size_t>(vc->length);
+    case SQL_SHORT:
+        return static_cast<size_t>(formatScaledInt(out,
+                *reinterpret_cast<const ISC_SHORT*>(v1.sqldata), v1.sqlscale) - out);
+    case SQL_LONG:
+        return static_cast<size_t>(formatScaledInt(out,
+                *reinterpret_cast<const ISC_LONG*>(v1.sqldata), v1.sqlscale) - out);
+    case SQL_INT64:
+        return static_cast<size_t>(formatScaledInt(out,
+                *reinterpret_cast<const ISC_INT64*>(v1.sqldata), v1.sqlscale) - out);
+    case SQL_FLOAT:
+        n = snprintf(out, size, "%.9g", *reinterpret_cast<const float*>(v1.sqldata));
+        break;
+    case SQL_DOUBLE:
+    case SQL_D_FLOAT:
+        n = snprintf(out, size, "%.17g", *reinterpret_cast<const double*>(v1.sqldata));
+        break;
+    case SQL_TYPE_DATE:
+        isc_decode_sql_date(reinterpret_cast<const ISC_DATE*>(v1.sqldata), &t);
+        n = snprintf(out, size, "%04d-%02d-%02d",
+                     t.tm_year + 1900, t.tm_mon + 1, t.tm_mday);
+        break;
+    case SQL_TYPE_TIME:
+        time = *reinterpret_cast<const ISC_TIME*>(v1.sqldata);
+        isc_decode_sql_time(&time, &t);
+        n = snprintf(out, size, "%02d:%02d:%02d.%04u",
+                     t.tm_hour, t.tm_min, t.tm_sec, time % 10000);
+        break;
+    case SQL_TIMESTAMP:
+        ts = reinterpret_cast<const ISC_TIMESTAMP*>(v1.sqldata);
+        isc_decode_timestamp(ts, &t);
+        n = snprintf(out, size, "%04d-%02d-%02d %02d:%02d:%02d.%04u",
+                     t.tm_year + 1900, t.tm_mon + 1, t.tm_mday,
+                     t.tm_hour, t.tm_min, t.tm_sec,
+                     ts->timestamp_time % 10000);
+        break;
+    default:
+        // boolean
+        n = snprintf(out, size, "%s",
+                     *reinterpret_cast<const unsigned char*>(v1.sqldata) ? "TRUE" : "FALSE");
+        break;
+    }
+    return std::min(static_cast<size_t>(std::max(n, 0)), size);
+}
+
+/**
+ * External file records are the columns as fixed width text, followed
+ * by one null flag ('N' or ' ') per column and a new line.
+ */
+static size_t externalRecordSize(const std::vector<unsigned int> &widths)
+{
+    size_t size = widths.size() + 1;
+    for (unsigned int w : widths) {
+        size += w;
+    }
+    return size;
+}
+
+static void formatRecord(const XSQLDA *sqlda,
+                         const std::vector<unsigned int> &widths,
+                         unsigned char *record)
+{
+    char *out = reinterpret_cast<char*>(record);
+    char *flags = out + externalRecordSize(widths) - widths.size() - 1;
+
+    for (int i = 0; i != sqlda->sqld; ++i) {
+        const XSQLVAR &v1 = sqlda->sqlvar[i];
+        const size_t width = widths[static_cast<size_t>(i)];
+        size_t length = 0;
+        if ((v1.sqltype & 1) && *v1.sqlind < 0) {
+            flags[i] = 'N';
+        } else {
+            flags[i] = ' ';
+            char buffer[64];
+            if (width > sizeof(buffer)) {
+                length = formatField(v1, out, width);
+            } else {
+                length = formatField(v1, buffer, sizeof(buffer));
+                memcpy(out, buffer, length);
+            }
+        }
+        memset(out + length, ' ', width - length);
+        out += width;
+    }
+    flags[sqlda->sqld] = '\n';
+}
+
+/**
+ * rows converted by a parser, in the layout of the INSERT parameters
+ * or as external file records
+ */
+struct ParsedBatch
+{
+    std::vector<unsigned char> rows_;
+    /** the input line of each row */
+    std::vector<LineRef> lines_;
+    /** lines that couldn't be converted */
+    std::vector<LineRef> rejected_;
+    /** input bytes covered by the batch */
+    size_t bytes_;
+
+    ParsedBatch() : rows_(), lines_(), rejected_(), bytes_(0)
+    {
+    }
+};
+
+/** parsed batches on their way from the parsers to the writer */
+struct LoadQueue
+{
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<ParsedBatch> batches_;
+    size_t capacity_;
+    unsigned int runningParsers_;
+    bool stop_;
+    std::exception_ptr error_;
+
+    LoadQueue(size_t capacity, unsigned int parsers) :
+                                mutex_(),
+                                notEmpty_(),
+                                notFull_(),
+                                batches_(),
+                                capacity_(capacity),
+                                runningParsers_(parsers),
+                                stop_(false),
+                                error_()
+    {
+    }
+
+    /** false if the load is stopping */
+    bool push(ParsedBatch &batch)
+    {
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            notFull_.wait(lk, [this] {
+                return stop_ || batches_.size() < capacity_;
+            });
+            if (stop_) {
+                return false;
+            }
+            batches_.push_back(std::move(batch));
+        }
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    /** false when all parsers finished and everything was taken */
+    bool pop(ParsedBatch &batch)
+    {
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            notEmpty_.wait(lk, [this] {
+                return stop_ || !batches_.empty() || runningParsers_ == 0;
+            });
+            if (error_) {
+                std::rethrow_exception(error_);
+            }
+            if (stop_ || batches_.empty()) {
+                return false;
+            }
+            batch = std::move(batches_.front());
+            batches_.pop_front();
+        }
+        notFull_.notify_one();
+        return true;
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> const lg(mutex_);
+            stop_ = true;
+        }
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
+};
+
+/**
+ * convert the lines of [begin, end) into rows, layout describes the
+ * INSERT parameters with data pointers into templateBase, a field
+ * buffer of paramsSize bytes. If widths is not null the rows are
+ * external file records.
+ */
+static void parseRange(const char *begin, const char *end,
+                       const XSQLDA *layout,
+                       const unsigned char *templateBase,
+                       size_t paramsSize,
+                       const std::vector<unsigned int> *widths,
+                       const DbBulkLoadOptions &opts,
+                       LoadQueue *queue)
+{
+    try {
+        std::unique_ptr<char[]> params(reinterpret_cast<char*>(cloneXsqlda(layout)));
+        XSQLDA *sqlda = reinterpret_cast<XSQLDA*>(params.get());
+        std::vector<unsigned char> row(paramsSize);
+        rebaseXsqldaFields(sqlda, templateBase, row.data());
+
+        const size_t rowSize = widths ? externalRecordSize(*widths) : paramsSize;
+        std::vector<Field> fields;
+        std::string scratch;
+        ParsedBatch batch;
+        batch.rows_.reserve(rowSize * opts.batchRows_);
+
+        for (const char *p = begin; p < end; ) {
+            const char *nl = static_cast<const char*>(
+                    memchr(p, '\n', static_cast<size_t>(end - p)));
+            const char *next = nl ? nl + 1 : end;
+            const char *e = nl ? nl : end;
+            if (e != p && e[-1] == '\r') {
+                --e;
+            }
+
+            if (e != p) {
+                const LineRef line = { p, static_cast<size_t>(e - p) };
+                bool converted = splitLine(p, e, opts.delimiter_, fields, scratch) &&
+                                 fields.size() == static_cast<size_t>(sqlda->sqld);
+                for (size_t i = 0; converted && i != fields.size(); ++i) {
+                    converted = convertField(sqlda->sqlvar[i], fields[i]);
+                }
+
+                if (converted && widths) {
+                    batch.rows_.resize(batch.rows_.size() + rowSize);
+                    formatRecord(sqlda, *widths,
+                                 batch.rows_.data() + batch.rows_.size() - rowSize);
+                    batch.lines_.push_back(line);
+                } else if (converted) {
+                    batch.rows_.insert(batch.rows_.end(), row.begin(), row.end());
+                    batch.lines_.push_back(line);
+                } else {
+                    batch.rejected_.push_back(line);
+                }
+            }
+            batch.bytes_ += static_cast<size_t>(next - p);
+            p = next;
+
+            if (batch.lines_.size() + batch.rejected_.size() >= opts.batchRows_) {
+                if (!queue->push(batch)) {
+                    break;
+                }
+                batch = ParsedBatch();
+                batch.rows_.reserve(rowSize * opts.batchRows_);
+            }
+        }
+
+        if (batch.bytes_ != 0) {
+            queue->push(batch);
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> const lg(queue->mutex_);
+        if (!queue->error_) {
+            queue->error_ = std::current_exception();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> const lg(queue->mutex_);
+        --queue->runningParsers_;
+    }
+    queue->notEmpty_.notify_all();
+}
+
+template <typename T>
+static bool readBinary(const char *&p, const char *e, T &value)
+{
+    if (static_cast<size_t>(e - p) < sizeof(value)) {
+        return false;
+    }
+    memcpy(&value, p, sizeof(value));
+    p += sizeof(value);
+    return true;
+}
+
+/**
+ * read the header of a binary row file (see BINARY_ROWS_MAGIC) and
+ * check its columns against the INSERT parameters
+ * \return the first row
+ */
+static const char *readBinaryHeader(const char *p, const char *e,
+                                    const XSQLDA *params)
+{
+    uint16_t count;
+    if (static_cast<size_t>(e - p) < BINARY_ROWS_MAGIC_LENGTH ||
+        memcmp(p, BINARY_ROWS_MAGIC, BINARY_ROWS_MAGIC_LENGTH) != 0 ||
+        !readBinary(p += BINARY_ROWS_MAGIC_LENGTH, e, count)) {
+        throw std::invalid_argument("The file has no binary rows!");
+    }
+
+    if (count != params->sqld) {
+        throw std::invalid_argument("The binary rows don't have a value "
+                                    "for each column!");
+    }
+
+    for (int i = 0; i != count; ++i) {
+        int16_t type, scale;
+        uint16_t length;
+        uint8_t nameLength;
+        if (!readBinary(p, e, type) || !readBinary(p, e, scale) ||
+            !readBinary(p, e, length) || !readBinary(p, e, nameLength) ||
+            e - p < nameLength) {
+            throw std::invalid_argument("The binary row header is truncated!");
+        }
+        p += nameLength;
+
+        // text lengths are checked for each value, the other values are
+        // copied as they are and must have the type of the column
+        const XSQLVAR &v1 = params->sqlvar[i];
+        const int columnType = v1.sqltype & ~1;
+        const bool text = (type == SQL_TEXT || type == SQL_VARYING);
+        const bool columnText = (columnType == SQL_TEXT || columnType == SQL_VARYING);
+        if (text != columnText ||
+            (!text && (type != columnType || scale != v1.sqlscale ||
+                       length != v1.sqllen))) {
+            throw std::invalid_argument("The type of binary column " +
+                                        std::to_string(i + 1) +
+                                        " doesn't match the table column!");
+        }
+    }
+    return p;
+}
+
+/** decode a binary row into the INSERT parameters */
+static bool readBinaryRow(const char *p, const char *e, XSQLDA *params)
+{
+    for (int i = 0; i != params->sqld; ++i) {
+        XSQLVAR &v1 = params->sqlvar[i];
+        uint8_t null;
+        if (!readBinary(p, e, null)) {
+            return false;
+        }
+
+        if (null) {
+            if ((v1.sqltype & 1) == 0) {
+                return false;
+            }
+            *v1.sqlind = -1;
+            continue;
+        }
+        if (v1.sqltype & 1) {
+            *v1.sqlind = 0;
+        }
+
+        const int type = v1.sqltype & ~1;
+        if (type == SQL_TEXT || type == SQL_VARYING) {
+            uint16_t length;
+            if (!readBinary(p, e, length) || e - p < length) {
+                return false;
+            }
+            const Field f = { p, length, true };
+            if (!convertField(v1, f)) {
+                return false;
+            }
+            p += length;
+        } else {
+            if (e - p < v1.sqllen) {
+                return false;
+            }
+            memcpy(v1.sqldata, p, static_cast<size_t>(v1.sqllen));
+            p += v1.sqllen;
+        }
+    }
+    return p == e;
+}
+
+/** the line past the one containing p, or end */
+static const char *nextLine(const char *p, const char *end)
+{
+    const char *nl = static_cast<const char*>(
+            memchr(p, '\n', static_cast<size_t>(end - p)));
+    return nl ? nl + 1 : end;
+}
+
+static std::string rejectMessage(const LineRef &line)
+{
+    return "bad input row: " +
+           std::string(line.data_, std::min<size_t>(line.length_, 200));
+}
+
+static void writeRaw(FILE *rejects, const char *data, size_t length)
+{
+    if (fwrite(data, 1, length, rejects) != length) {
+        throw std::runtime_error("Failed to write to the reject file!");
+    }
+}
+
+static void writeReject(FILE *rejects, const LineRef &line)
+{
+    writeRaw(rejects, line.data_, line.length_);
+    writeRaw(rejects, "\n", 1);
+}
+
+/** write the bad rows of a batch to the reject file, or throw */
+static void rejectLines(FILE *rejects, const std::vector<LineRef> &lines,
+                        DbBulkLoadProgress &progress)
+{
+    for (const LineRef &line : lines) {
+        if (!rejects) {
+            throw std::invalid_argument(rejectMessage(line));
+        }
+        writeReject(rejects, line);
+        ++progress.rowsRejected_;
+    }
+}
+
+static void updateRate(DbBulkLoadProgress &progress,
+                       std::chrono::steady_clock::time_point startTime)
+{
+    progress.elapsedSeconds_ = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - startTime).count();
+    progress.rowsPerSecond_ = progress.elapsedSeconds_ > 0 ?
+            progress.rowsLoaded_ / progress.elapsedSeconds_ : 0;
+}
+
+/**
+ * split [begin, end) on line boundaries between the parser threads and
+ * hand each of their batches to consume, on the calling thread
+ */
+static void runParsers(const char *begin, const char *end,
+                       const XSQLDA *params,
+                       const unsigned char *paramsBase,
+                       size_t paramsSize,
+                       const std::vector<unsigned int> *widths,
+                       const DbBulkLoadOptions &opts,
+                       const std::function<void (ParsedBatch &batch)> &consume)
+{
+    unsigned int parsers = opts.parserThreads_;
+    if (parsers == 0) {
+        parsers = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    std::vector<const char*> cuts(1, begin);
+    for (unsigned int k = 1; k < parsers; ++k) {
+        const char *cut = begin + static_cast<size_t>(end - begin) * k / parsers;
+        cut = std::max(cut, cuts.back());
+        cuts.push_back(cut == begin ? begin : nextLine(cut - 1, end));
+    }
+    cuts.push_back(end);
+
+    LoadQueue queue(2 * parsers, parsers);
+    std::vector<std::thread> threads;
+
+    try {
+        for (unsigned int k = 0; k != parsers; ++k) {
+            threads.emplace_back(parseRange, cuts[k], cuts[k + 1],
+                                 params, paramsBase, paramsSize, widths,
+                                 std::cref(opts), &queue);
+        }
+
+        ParsedBatch batch;
+        while (queue.pop(batch)) {
+            consume(batch);
+        }
+    } catch (...) {
+        queue.stop();
+        for (auto &t : threads) {
+            t.join();
+        }
+        throw;
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+}
+
+} /* anonymous namespace */
+
+DbBulkLoader::DbBulkLoader(DbConnection &connection,
+                           const char *table,
+                           const char *columns,
+                           const DbBulkLoadOptions &opts
+                                /* = DbBulkLoadOptions() */) :
+                                connection_(connection),
+                                table_(table ? table : ""),
+                                columns_(columns ? columns : ""),
+                                insertSql_(),
+                                opts_(opts)
+{
+    if (!table || !columns || !*columns) {
+        throw std::invalid_argument("invalid bulk load arguments!");
+    }
+
+    if (opts_.batchRows_ == 0) {
+        opts_.batchRows_ = 1;
+    }
+
+    // one parameter per column, commas in quoted names don't count
+    unsigned int count = 1;
+    for (const char *p = columns; *p; ) {
+        const char *next = skipLiteralOrComment(p);
+        if (next != p) {
+            p = next;
+            continue;
+        }
+        count += (*p++ == ',');
+    }
+
+    insertSql_ = "INSERT INTO ";
+    insertSql_.append(table).append(" (").append(columns).append(") VALUES (");
+    for (unsigned int i = 0; i != count; ++i) {
+        insertSql_ += i ? ", ?" : "?";
+    }
+    insertSql_ += ')';
+}
+
+DbBulkLoadProgress DbBulkLoader::load(const char *fileName)
+{
+    if (!fileName) {
+        throw std::invalid_argument("null file name!");
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    MappedFile file(fileName);
+
+    DbTransaction tr(connection_.nativeHandle(), 1,
+                     DefaultTransMode::Rollback,
+                     TransStartMode::StartReadWrite);
+    DbStatement st = prepareInsert(tr);
+    const size_t rowSize = xsqldaFieldsSize(st.inParams_, st.inFields_);
+    std::unique_ptr<FILE, int (*)(FILE*)> rejects(openRejectFile(), fclose);
+
+    DbBulkLoadProgress progress;
+    progress.bytesTotal_ = file.size();
+    const char *begin = skipHeader(file.begin(), file.end(), progress);
+
+    auto lastReport = startTime;
+    uint64_t uncommitted = 0;
+
+    runParsers(begin, file.end(), st.inParams_, st.inFields_, rowSize,
+               nullptr, opts_, [&](ParsedBatch &batch) {
+        rejectLines(rejects.get(), batch.rejected_, progress);
+
+        for (size_t r = 0; r != batch.lines_.size(); ++r) {
+            memcpy(st.inFields_, batch.rows_.data() + r * rowSize, rowSize);
+            try {
+                st.execute();
+            } catch (FbException &) {
+                // a failed statement doesn't affect the transaction
+                if (!rejects) {
+                    throw;
+                }
+                writeReject(rejects.get(), batch.lines_[r]);
+                ++progress.rowsRejected_;
+                continue;
+            }
+            ++progress.rowsLoaded_;
+
+            if (++uncommitted >= opts_.commitRows_) {
+                tr.commitRetain();
+                uncommitted = 0;
+            }
+        }
+        progress.bytesRead_ += batch.bytes_;
+        reportProgress(progress, startTime, lastReport);
+    });
+
+    tr.commit();
+    updateRate(progress, startTime);
+    return progress;
+}
+
+DbBulkLoadProgress DbBulkLoader::loadExternal(const char *fileName,
+                                              const char *externalFile)
+{
+    if (!fileName || !externalFile) {
+        throw std::invalid_argument("null file name!");
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    MappedFile file(fileName);
+
+    DbTransaction tr(connection_.nativeHandle(), 1,
+                     DefaultTransMode::Rollback,
+                     TransStartMode::StartReadWrite);
+
+    // the INSERT is prepared only to learn the types of the columns
+    std::vector<unsigned int> widths;
+    DbStatement st = prepareInsert(tr);
+    const size_t paramsSize = xsqldaFieldsSize(st.inParams_, st.inFields_);
+    for (int i = 0; i != st.inParams_->sqld; ++i) {
+        widths.push_back(std::max(externalWidth(st.inParams_->sqlvar[i]), 1u));
+    }
+
+    std::unique_ptr<FILE, int (*)(FILE*)> rejects(openRejectFile(), fclose);
+    std::unique_ptr<FILE, int (*)(FILE*)> records(fopen(externalFile, "wb"), fclose);
+    if (!records) {
+        throw std::runtime_error(std::string("Failed to create ") +
+                                 externalFile + ": " + strerror(errno));
+    }
+
+    DbBulkLoadProgress progress;
+    progress.bytesTotal_ = file.size();
+    const char *begin = skipHeader(file.begin(), file.end(), progress);
+    auto lastReport = startTime;
+    uint64_t recordCount = 0;
+
+    try {
+        runParsers(begin, file.end(), st.inParams_, st.inFields_, paramsSize,
+                   &widths, opts_, [&](ParsedBatch &batch) {
+            rejectLines(rejects.get(), batch.rejected_, progress);
+            if (fwrite(batch.rows_.data(), 1, batch.rows_.size(),
+                       records.get()) != batch.rows_.size()) {
+                throw std::runtime_error("Failed to write the external file!");
+            }
+            recordCount += batch.lines_.size();
+            progress.bytesRead_ += batch.bytes_;
+            reportProgress(progress, startTime, lastReport);
+        });
+
+        if (fclose(records.release()) != 0) {
+            throw std::runtime_error("Failed to write the external file!");
+        }
+        st.close();
+
+        loadExternalFile(tr, externalFile, widths);
+    } catch (...) {
+        records.reset();
+        unlink(externalFile);
+        throw;
+    }
+    unlink(externalFile);
+
+    progress.rowsLoaded_ = recordCount;
+    updateRate(progress, startTime);
+    return progress;
+}
+
+DbBulkLoadProgress DbBulkLoader::loadBinary(const char *fileName)
+{
+    if (!fileName) {
+        throw std::invalid_argument("null file name!");
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    MappedFile file(fileName);
+
+    DbTransaction tr(connection_.nativeHandle(), 1,
+                     DefaultTransMode::Rollback,
+                     TransStartMode::StartReadWrite);
+    DbStatement st = prepareInsert(tr);
+    std::unique_ptr<FILE, int (*)(FILE*)> rejects(openRejectFile(), fclose);
+
+    const char *end = file.end();
+    const char *p = readBinaryHeader(file.begin(), end, st.inParams_);
+    if (rejects) {
+        // the reject file can be loaded like the input
+        writeRaw(rejects.get(), file.begin(), static_cast<size_t>(p - file.begin()));
+    }
+
+    DbBulkLoadProgress progress;
+    progress.bytesTotal_ = file.size();
+    progress.bytesRead_ = static_cast<uint64_t>(p - file.begin());
+    auto lastReport = startTime;
+    uint64_t uncommitted = 0;
+
+    while (p != end) {
+        uint32_t length;
+        const char *row = p;
+        if (!readBinary(p, end, length) ||
+            static_cast<size_t>(end - p) < length) {
+            throw std::runtime_error("The binary rows are truncated!");
+        }
+        const char *next = p + length;
+
+        bool loaded = readBinaryRow(p, next, st.inParams_);
+        if (!loaded && !rejects) {
+            throw std::invalid_argument("bad binary row at offset " +
+                                        std::to_string(row - file.begin()));
+        }
+
+        if (loaded) {
+            try {
+                st.execute();
+            } catch (FbException &) {
+                // a failed statement doesn't affect the transaction
+                if (!rejects) {
+                    throw;
+                }
+                loaded = false;
+            }
+        }
+
+        if (loaded) {
+            ++progress.rowsLoaded_;
+            if (++uncommitted >= opts_.commitRows_) {
+                tr.commitRetain();
+                uncommitted = 0;
+            }
+        } else {
+            writeRaw(rejects.get(), row, static_cast<size_t>(next - row));
+            ++progress.rowsRejected_;
+        }
+
+        progress.bytesRead_ += static_cast<uint64_t>(next - row);
+        p = next;
+        if ((progress.rowsLoaded_ + progress.rowsRejected_) % 1024 == 0) {
+            reportProgress(progress, startTime, lastReport);
+        }
+    }
+
+    tr.commit();
+    updateRate(progress, startTime);
+    return progress;
+}
+
+void DbBulkLoader::loadExternalFile(DbTransaction &tr,
+                                    const char *externalFile,
+                                    const std::vector<unsigned int> &widths)
+{
+    static std::atomic<unsigned int> tableCounter(0);
+    char name[32];
+    snprintf(name, sizeof(name), "DBWRAP_EXT_%d_%u", static_cast<int>(getpid()),
+             tableCounter.fetch_add(1));
+
+    std::string path(externalFile);
+    for (size_t i = 0; (i = path.find('\'', i)) != std::string::npos; i += 2) {
+        path.insert(i, 1, '\'');
+    }
+
+    // every column is fixed width text, the server converts the values
+    // to the column types as they are inserted
+    std::string create = "CREATE TABLE ";
+    create.append(name).append(" EXTERNAL FILE '").append(path).append("' (");
+    std::string select = "SELECT ";
+    for (size_t i = 0; i != widths.size(); ++i) {
+        const std::string column = "C" + std::to_string(i + 1);
+        create += column + " CHAR(" + std::to_string(widths[i]) +
+                  ") CHARACTER SET NONE, ";
+        select += i ? ", " : "";
+        select += "CASE WHEN SUBSTRING(NULL_FLAGS FROM " + std::to_string(i + 1) +
+                  " FOR 1) = 'N' THEN NULL ELSE TRIM(TRAILING FROM " + column +
+                  ") END";
+    }
+    create += "NULL_FLAGS CHAR(" + std::to_string(widths.size()) +
+              ") CHARACTER SET NONE, EOL CHAR(1) CHARACTER SET NONE)";
+    select.append(" FROM ").append(name);
+
+    connection_.executeUpdate(create.c_str(), &tr);
+    tr.commitRetain();
+
+    std::string drop = std::string("DROP TABLE ") + name;
+    try {
+        std::string insert = "INSERT INTO ";
+        insert.append(table_).append(" (").append(columns_).append(") ")
+              .append(select);
+        connection_.executeUpdate(insert.c_str(), &tr);
+        tr.commitRetain();
+    } catch (...) {
+        try {
+            tr.rollbackRetain();
+            connection_.executeUpdate(drop.c_str(), &tr);
+            tr.commit();
+        } catch (std::exception &) {
+        }
+        throw;
+    }
+
+    connection_.executeUpdate(drop.c_str(), &tr);
+    tr.commit();
+}
+
+DbStatement DbBulkLoader::prepareInsert(DbTransaction &tr)
+{
+    DbStatement st = connection_.createStatement(insertSql_.c_str(), &tr);
+    if (!st.inParams_) {
+        st.createBoundParametersBlock();
+    }
+
+    for (int i = 0; i != st.inParams_->sqld; ++i) {
+        if (!isSupportedType(st.inParams_->sqlvar[i])) {
+            throw std::invalid_argument("The bulk loader doesn't support the type "
+                                        "of column " + std::to_string(i + 1));
+        }
+    }
+    return st;
+}
+
+FILE *DbBulkLoader::openRejectFile() const
+{
+    if (opts_.rejectFile_.empty()) {
+        return nullptr;
+    }
+
+    FILE *rejects = fopen(opts_.rejectFile_.c_str(), "wb");
+    if (!rejects) {
+        throw std::runtime_error("Failed to open the reject file " +
+                                 opts_.rejectFile_ + ": " + strerror(errno));
+    }
+    return rejects;
+}
+
+const char *DbBulkLoader::skipHeader(const char *begin, const char *end,
+                                     DbBulkLoadProgress &progress) const
+{
+    if (opts_.header_ && begin != end) {
+        const char *first = nextLine(begin, end);
+        progress.bytesRead_ += static_cast<uint64_t>(first - begin);
+        return first;
+    }
+    return begin;
+}
+
+void DbBulkLoader::reportProgress(DbBulkLoadProgress &progress,
+                                  std::chrono::steady_clock::time_point startTime,
+                                  std::chrono::steady_clock::time_point &lastReport) const
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (opts_.onProgress_ &&
+        now - lastReport >= std::chrono::milliseconds(opts_.progressIntervalMs_)) {
+        lastReport = now;
+        updateRate(progress, startTime);
+        opts_.onProgress_(progress);
+    }
+}
+
+} /* namespace fb */
@@ -0,0 +1,169 @@
+/*
+ * DbBulkLoader.h - load large delimited (CSV, TSV) files into a table
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBBULKLOADER_H_
+#define DBWRAP_FB_SRC_FB_DBBULKLOADER_H_
+
+#include "DbStatement.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+namespace fb
+{
+
+// forward declarations
+class DbConnection;
+class DbTransaction;
+
+struct DbBulkLoadProgress
+{
+    uint64_t rowsLoaded_;
+    /** rows that couldn't be parsed or were refused by the server */
+    uint64_t rowsRejected_;
+    /** input bytes handed over to the writer */
+    uint64_t bytesRead_;
+    uint64_t bytesTotal_;
+    double elapsedSeconds_;
+    double rowsPerSecond_;
+
+    DbBulkLoadProgress() : rowsLoaded_(0),
+                           rowsRejected_(0),
+                           bytesRead_(0),
+                           bytesTotal_(0),
+                           elapsedSeconds_(0),
+                           rowsPerSecond_(0)
+    {
+    }
+};
+
+struct DbBulkLoadOptions
+{
+    /** field delimiter, ',' for CSV or '\t' for TSV */
+    char delimiter_;
+    /** skip the first line of the file */
+    bool header_;
+    /** number of parser threads, 0 for one per CPU core */
+    unsigned int parserThreads_;
+    /** commit (retaining the transaction) after this many rows */
+    unsigned int commitRows_;
+    /** rows a parser hands over to the writer at a time */
+    unsigned int batchRows_;
+    /**
+     * bad rows are written to this file as they are in the input,
+     * if empty the first bad row stops the load with an exception
+     */
+    std::string rejectFile_;
+    /** called by the loading thread about every progressIntervalMs_ */
+    std::function<void (const DbBulkLoadProgress &progress)> onProgress_;
+    unsigned int progressIntervalMs_;
+
+    explicit DbBulkLoadOptions(char delimiter = ',', bool header = false)
+              : delimiter_(delimiter),
+                header_(header),
+                parserThreads_(0),
+                commitRows_(50000),
+                batchRows_(1024),
+                rejectFile_(),
+                onProgress_(),
+                progressIntervalMs_(1000)
+    {
+    }
+};
+
+/**
+ * Loads a delimited text file into a table. The file is memory mapped
+ * and split on line boundaries between parser threads, they convert the
+ * fields straight into the typed parameters of the prepared INSERT
+ * statement. The calling thread executes the INSERT for each row and
+ * commits (retaining the transaction) every commitRows_ rows.
+ *
+ * Fields are separated by the delimiter and may be quoted with '"',
+ * a quote inside a quoted field is doubled. Quoted fields can't span
+ * lines. An empty, unquoted field is NULL. Dates, times and timestamps
+ * are read as "YYYY-MM-DD", "HH:MM:SS.ffff" and "YYYY-MM-DD HH:MM:SS.ffff",
+ * exact numerics refuse digits their scale can't hold. Blob and other
+ * column types are not supported.
+ */
+class DbBulkLoader
+{
+public:
+    /**
+     * \param columns the table columns in the order of the file fields,
+     *  e.g. "ID, NAME, PRICE"
+     */
+    DbBulkLoader(DbConnection &connection,
+                 const char *table,
+                 const char *columns,
+                 const DbBulkLoadOptions &opts = DbBulkLoadOptions());
+
+    /**
+     * load the file, the rows committed before an exception stops the
+     * load stay in the table
+     * \return the final counters of the load
+     */
+    DbBulkLoadProgress load(const char *fileName);
+
+    /**
+     * load a binary row file written by DbExporter, its columns must
+     * have the types of the table columns, text values are checked
+     * against the column lengths. Rejected rows are written to the
+     * reject file after the header of the input, so it can be loaded
+     * the same way.
+     */
+    DbBulkLoadProgress loadBinary(const char *fileName);
+
+    /**
+     * Load the file through an EXTERNAL FILE table: the rows are
+     * converted into fixed width records written to externalFile,
+     * then the server inserts them all with a single INSERT ... SELECT.
+     * The server must be able to read externalFile under the same path
+     * (ExternalFileAccess in firebird.conf), the file is removed when
+     * the load is done. Text values lose their trailing spaces. If the
+     * server refuses a row nothing is loaded.
+     */
+    DbBulkLoadProgress loadExternal(const char *fileName,
+                                    const char *externalFile);
+
+private:
+    DbBulkLoader(const DbBulkLoader&) = delete;
+    DbBulkLoader &operator=(const DbBulkLoader&) = delete;
+
+    /** prepare the INSERT and check its parameter types */
+    DbStatement prepareInsert(DbTransaction &tr);
+    void loadExternalFile(DbTransaction &tr, const char *externalFile,
+                          const std::vector<unsigned int> &widths);
+    /** null if there's no reject file */
+    FILE *openRejectFile() const;
+    const char *skipHeader(const char *begin, const char *end,
+                           DbBulkLoadProgress &progress) const;
+    void reportProgress(DbBulkLoadProgress &progress,
+                        std::chrono::steady_clock::time_point startTime,
+                        std::chrono::steady_clock::time_point &lastReport) const;
+
+    DbConnection &connection_;
+    std::string table_;
+    std::string columns_;
+    std::string insertSql_;
+    DbBulkLoadOptions opts_;
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBBULKLOADER_H_ */
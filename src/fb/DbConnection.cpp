@@ -18,14 +18,17 @@
 #include "DbStatement.h"
 #include "DbTransaction.h"
 #include "FbException.h"
+#include "FbInternals.h"
 
 #include <ibase.h>
 
 #include <array>
 #include <cassert>
+#include <climits>
 #include <cstring>
 #include <memory>
 #include <string>
+#include <utility>
 
 
 namespace fb {
@@ -33,7 +36,8 @@ namespace fb {
 DbConnection::DbConnection(const char *dbName, const char *server,
         const char *userName, const char *userPassword,
         const DbCreateOptions *opts) :
-        connectMutex_(), db_(0), eventSettings_(nullptr)
+        connectMutex_(), db_(0), eventSettings_(nullptr),
+        autoCommitTrans_(nullptr)
 {
     // check some static assertions
     static_assert(sizeof(db_) == sizeof(isc_db_handle),
@@ -45,6 +49,7 @@ DbConnection::DbConnection(const char *dbName, const char *server,
 DbConnection::~DbConnection()
 {
     disableEvents();
+    delete autoCommitTrans_;
     dissconnect();
 }
 
@@ -201,9 +206,31 @@ const FbApiHandle *DbConnection::nativeHandle() const
     return db_ ? &db_ : nullptr;
 }
 
+void DbConnection::setAutoCommit(bool enable)
+{
+    if (enable == (autoCommitTrans_ != nullptr)) {
+        return;
+    }
+
+    if (enable) {
+        autoCommitTrans_ = new DbTransaction(&db_, 1,
+                                             DefaultTransMode::Commit,
+                                             TransStartMode::StartAutoCommit);
+    } else {
+        delete autoCommitTrans_;
+        autoCommitTrans_ = nullptr;
+    }
+}
+
+bool DbConnection::autoCommit() const
+{
+    return autoCommitTrans_ != nullptr;
+}
+
 /**
- * If transaction is null then a new one is created and committed.
- * else the caller is responsible for committing or rolling
+ * If transaction is null then the autocommit transaction is used if
+ * enabled, else a new one is created and committed.
+ * Otherwise the caller is responsible for committing or rolling
  * back the transaction.
  */
 void DbConnection::executeUpdate(const char *updateSql,
@@ -216,7 +243,101 @@ void DbConnection::executeUpdate(const char *updateSql,
     std::unique_ptr<DbTransaction> trPtr;
 
     assert(updateSql);
-    if (transaction == nullptr) {
+    if (transaction == nullptr && autoCommitTrans_) {
+        transaction = autoCommitTrans_;
+    } else if (transaction == nullptr) {
+        transaction = new DbTransaction(&db_, 1,
+                                        DefaultTransMode::Rollback,
+                                        TransStartMode::StartReadWrite);
+        trPtr.reset(transaction);
+    }
+
+    std::unique_ptr<QueryDigestCall> digestCall(newQueryDigestCall(updateSql));
+    {
+        QueryDigestPhase digest(digestCall.get(), QueryDigestCall::Execute);
+        digest.finish();
+
+        ISC_STATUS_ARRAY status;
+        if (isc_dsql_execute_immediate(status, &db_, transaction->nativeHandle(),
+                                       0, updateSql, FB_SQL_DIALECT, nullptr)) {
+            digest.fail();
+            throw FbException("update/create/insert statement failed!", status);
+        }
+    }
+
+    if (trPtr) {
+        trPtr->commit();
+    }
+}
+
+constexpr int DbConnection::IMMEDIATE_COLUMN_LENGTH;
+
+/**
+ * The input XSQLDA is described on the client from the parameter values
+ * so that the statement needs neither a prepare nor a describe_bind.
+ * Returns false if the statement didn't return a row.
+ */
+bool DbConnection::executeImmediate2(const char *sql,
+                                     const std::vector<DbParam> &params,
+                                     SqlDescriptorArea *results,
+                                     DbTransaction *transaction)
+{
+    if (db_ == 0) {
+        throw FbException("No database connection!", nullptr);
+    }
+
+    assert(sql);
+    const size_t count = params.size();
+    if (count > SHRT_MAX) {
+        throw std::invalid_argument("too many statement parameters!");
+    }
+
+    std::unique_ptr<char[]> inBuffer;
+    XSQLDA *inParams = nullptr;
+    std::vector<ISC_INT64> ints(count);
+    std::vector<ISC_SHORT> nullInds(count);
+
+    if (count > 0) {
+        inBuffer.reset(new char[XSQLDA_LENGTH(count)]);
+        memset(inBuffer.get(), 0, XSQLDA_LENGTH(count));
+        inParams = reinterpret_cast<XSQLDA*>(inBuffer.get());
+        inParams->version = SQLDA_VERSION1;
+        inParams->sqln = static_cast<ISC_SHORT>(count);
+        inParams->sqld = static_cast<ISC_SHORT>(count);
+    }
+
+    for (size_t i = 0; i != count; ++i) {
+        const DbParam &p = params[i];
+        XSQLVAR &v1 = inParams->sqlvar[i];
+        v1.sqlind = &nullInds[i];
+        switch (p.type()) {
+        case DbParam::Type::Null:
+            v1.sqltype = SQL_TEXT + 1;
+            v1.sqllen = 1;
+            v1.sqldata = const_cast<ISC_SCHAR*>(" ");
+            nullInds[i] = -1;
+            break;
+        case DbParam::Type::Int:
+            ints[i] = p.intValue();
+            v1.sqltype = SQL_INT64 + 1;
+            v1.sqllen = sizeof(ISC_INT64);
+            v1.sqldata = reinterpret_cast<ISC_SCHAR*>(&ints[i]);
+            break;
+        case DbParam::Type::Text:
+            if (p.textValue().size() > SHRT_MAX) {
+                throw std::invalid_argument("text parameter is too long!");
+            }
+            v1.sqltype = SQL_TEXT + 1;
+            v1.sqllen = static_cast<ISC_SHORT>(p.textValue().size());
+            v1.sqldata = const_cast<ISC_SCHAR*>(p.textValue().data());
+            break;
+        }
+    }
+
+    std::unique_ptr<DbTransaction> trPtr;
+    if (transaction == nullptr && autoCommitTrans_) {
+        transaction = autoCommitTrans_;
+    } else if (transaction == nullptr) {
         transaction = new DbTransaction(&db_, 1,
                                         DefaultTransMode::Rollback,
                                         TransStartMode::StartReadWrite);
@@ -224,22 +345,84 @@ void DbConnection::executeUpdate(const char *updateSql,
     }
 
     ISC_STATUS_ARRAY status;
-    if (isc_dsql_execute_immediate(status, &db_, transaction->nativeHandle(),
-                                   0, updateSql, FB_SQL_DIALECT, nullptr)) {
-        throw FbException("update/create/insert statement failed!", status);
+    ISC_STATUS rc = isc_dsql_exec_immed2(status, &db_,
+                                         transaction->nativeHandle(),
+                                         0, sql, FB_SQL_DIALECT,
+                                         inParams, results);
+    // 100 means a singleton select didn't find any row
+    if (rc != 0 && rc != 100) {
+        throw FbException("Failed to execute immediate statement.", status);
     }
 
     if (trPtr) {
         trPtr->commit();
     }
+    return rc == 0;
+}
+
+void DbConnection::executeImmediate(const char *sql,
+                                    const std::vector<DbParam> &params,
+                                    DbTransaction *transaction /* = nullptr */)
+{
+    executeImmediate2(sql, params, nullptr, transaction);
+}
+
+DbResultRow DbConnection::executeImmediateRow(const char *sql,
+                                    unsigned int columns,
+                                    const std::vector<DbParam> &params,
+                                    DbTransaction *transaction /* = nullptr */)
+{
+    if (columns == 0 || columns > SHRT_MAX) {
+        throw std::invalid_argument("invalid result column count!");
+    }
+
+    // the server converts each output column to the VARCHAR we
+    // describe here, so we don't need to describe the statement
+    SqlDescriptorArea *results = reinterpret_cast<SqlDescriptorArea*>(
+                                        new char[XSQLDA_LENGTH(columns)]);
+    memset(results, 0, XSQLDA_LENGTH(columns));
+    results->version = SQLDA_VERSION1;
+    results->sqln = static_cast<ISC_SHORT>(columns);
+    results->sqld = static_cast<ISC_SHORT>(columns);
+    for (unsigned int i = 0; i != columns; ++i) {
+        results->sqlvar[i].sqltype = SQL_VARYING + 1;
+        results->sqlvar[i].sqllen = IMMEDIATE_COLUMN_LENGTH;
+    }
+
+    unsigned char *fields = nullptr;
+    try {
+        fields = allocateAndSetXsqldaFields(results);
+        bool hasRow = executeImmediate2(sql, params, results, transaction);
+        return DbResultRow(results, fields, hasRow);
+    } catch (...) {
+        delete [] reinterpret_cast<char*>(results);
+        delete [] fields;
+        throw;
+    }
 }
 
 DbStatement DbConnection::createStatement(const char *query,
                                     DbTransaction *transaction /* = nullptr */)
 {
+    if (transaction == nullptr) {
+        // in autocommit mode the statement uses the shared autocommit
+        // transaction, otherwise autoCommitTrans_ is null and the
+        // statement creates and owns its transaction
+        transaction = autoCommitTrans_;
+    }
     return DbStatement(&db_, transaction, query);
 }
 
+DbStatement DbConnection::createNamedStatement(const char *query,
+                                    DbTransaction *transaction /* = nullptr */)
+{
+    assert(query);
+    std::shared_ptr<const NamedSql> named = parseNamedSql(query);
+    DbStatement st = createStatement(named->sql_.c_str(), transaction);
+    st.named_ = std::move(named);
+    return st;
+}
+
 // = = = = = = = = = BEGIN PETE SHEW event callback support  = = = = = = = = =
 // December 2018 modifications by Pete Shew pete@shew.org
 
@@ -16,6 +16,8 @@
 #ifndef DBWRAP_FB_SRC_DBCONNECTION_H_
 #define DBWRAP_FB_SRC_DBCONNECTION_H_
 
+#include "DbParam.h"
+#include "DbResultRow.h"
 #include "FbCommon.h"
 
 #include <mutex>
@@ -100,8 +102,64 @@ public:
     DbStatement createStatement(const char *query,
                                 DbTransaction *transaction = nullptr);
 
+    /**
+     * Like createStatement, for queries using named (":name") parameters.
+     * The SQL text is rewritten to use '?' parameters once per program run,
+     * don't use it for PSQL code where ":name" refers to local variables.
+     */
+    DbStatement createNamedStatement(const char *query,
+                                     DbTransaction *transaction = nullptr);
+
+    /**
+     * Execute a statement with '?' parameters in a single round trip,
+     * without allocating and preparing a statement handle. Use it for
+     * statements executed only once, prepare a DbStatement otherwise.
+     * The transaction is handled the same way as by executeUpdate.
+     */
+    void executeImmediate(const char *sql,
+                          const std::vector<DbParam> &params,
+                          DbTransaction *transaction = nullptr);
+
+    template <typename... Params>
+    void executeImmediate(const char *sql, const Params&... params)
+    {
+        executeImmediate(sql, std::vector<DbParam>{ DbParam(params)... });
+    }
+
+    /**
+     * Like executeImmediate, for singleton SELECT statements and for
+     * statements with a RETURNING clause. The statement must return
+     * exactly `columns` columns, their values are returned as text of at
+     * most IMMEDIATE_COLUMN_LENGTH bytes so blob columns are not supported.
+     */
+    DbResultRow executeImmediateRow(const char *sql,
+                                    unsigned int columns,
+                                    const std::vector<DbParam> &params,
+                                    DbTransaction *transaction = nullptr);
+
+    template <typename... Params>
+    DbResultRow executeImmediateRow(const char *sql, unsigned int columns,
+                                    const Params&... params)
+    {
+        return executeImmediateRow(sql, columns,
+                                   std::vector<DbParam>{ DbParam(params)... });
+    }
+
+    /** maximum length of a value returned by executeImmediateRow */
+    static constexpr int IMMEDIATE_COLUMN_LENGTH = 4096;
+
     const FbApiHandle *nativeHandle() const;
 
+    /**
+     * In autocommit mode updates and statements created without a
+     * transaction share one long lived transaction that the server
+     * commits after each statement, instead of starting and committing
+     * a new transaction each time. Statements created in autocommit
+     * mode must be destroyed before autocommit is turned off.
+     */
+    void setAutoCommit(bool enable);
+    bool autoCommit() const;
+
     /** event handling is experimental, use at own risk */
     void enableEvents(EventCallback callback, void *callbackData,
             const std::vector<std::string> &eventNames);
@@ -116,11 +174,18 @@ private:
                  const DbCreateOptions *opts);
     bool dissconnect();
 
+    /** common part of executeImmediate and executeImmediateRow */
+    bool executeImmediate2(const char *sql,
+                           const std::vector<DbParam> &params,
+                           SqlDescriptorArea *results,
+                           DbTransaction *transaction);
+
     std::mutex connectMutex_;
     FbApiHandle db_; /** database handle isc_db_handle a.k.a unsigned int */
 
     struct EventSettings;
     EventSettings *eventSettings_; /** event settings if enabled, otherwise null */
+    DbTransaction *autoCommitTrans_; /** shared transaction in autocommit mode, otherwise null */
 };
 
 } /* namespace fb */
@@ -0,0 +1,332 @@
+/*
+ * DbExecutionStats.cpp - server side cost of a statement execution
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbExecutionStats.h"
+
+#include "DbRowProxy.h"
+#include "FbException.h"
+#include "FbInternals.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+
+namespace fb
+{
+
+namespace {
+
+static uint64_t portableInt(const char *p, size_t length)
+{
+    return static_cast<uint64_t>(isc_portable_integer(
+            reinterpret_cast<const ISC_UCHAR*>(p), static_cast<short>(length)));
+}
+
+/** sequential or indexed per table reads, 2 byte relation ids and 4 byte counts */
+static void parseTableCounts(const char *p, size_t length,
+                             DatabaseCounters &counters, bool indexed)
+{
+    for (; length >= 6; p += 6, length -= 6) {
+        TableReadCounts reads;
+        reads.relationId_ = static_cast<unsigned int>(portableInt(p, 2));
+        reads.sequential_ = indexed ? 0 : portableInt(p + 2, 4);
+        reads.indexed_ = indexed ? portableInt(p + 2, 4) : 0;
+        counters.tableReads_.push_back(reads);
+    }
+}
+
+static bool lowerRelationId(const TableReadCounts &a, const TableReadCounts &b)
+{
+    return a.relationId_ < b.relationId_;
+}
+
+/** sort the table reads by relation id, one entry per relation */
+static void mergeTableCounts(std::vector<TableReadCounts> &tables)
+{
+    std::sort(tables.begin(), tables.end(), lowerRelationId);
+    size_t n = 0;
+    for (size_t i = 0; i != tables.size(); ++i) {
+        if (n != 0 && tables[n - 1].relationId_ == tables[i].relationId_) {
+            tables[n - 1].sequential_ += tables[i].sequential_;
+            tables[n - 1].indexed_ += tables[i].indexed_;
+        } else {
+            tables[n++] = tables[i];
+        }
+    }
+    tables.resize(n);
+}
+
+/**
+ * parse an isc_database_info reply into counters
+ * \return false if the reply was truncated
+ */
+static bool parseDatabaseCounters(const std::vector<char> &reply,
+                                  DatabaseCounters &counters)
+{
+    // clear() keeps the capacity of the table reads
+    counters.reads_ = 0;
+    counters.writes_ = 0;
+    counters.fetches_ = 0;
+    counters.marks_ = 0;
+    counters.tableReads_.clear();
+
+    const char *p = &reply[0];
+    const char *end = p + reply.size();
+    while (p < end && *p != isc_info_end) {
+        const char item = *p;
+        if (item == isc_info_truncated || p + 3 > end) {
+            return false;
+        }
+        size_t length = static_cast<size_t>(portableInt(p + 1, 2));
+        p += 3;
+        if (p + length > end) {
+            return false;
+        }
+
+        switch (item) {
+        case isc_info_reads:
+            counters.reads_ = portableInt(p, length);
+            break;
+        case isc_info_writes:
+            counters.writes_ = portableInt(p, length);
+            break;
+        case isc_info_fetches:
+            counters.fetches_ = portableInt(p, length);
+            break;
+        case isc_info_marks:
+            counters.marks_ = portableInt(p, length);
+            break;
+        case isc_info_read_seq_count:
+            parseTableCounts(p, length, counters, false);
+            break;
+        case isc_info_read_idx_count:
+            parseTableCounts(p, length, counters, true);
+            break;
+        default:
+            break;
+        }
+        p += length;
+    }
+    mergeTableCounts(counters.tableReads_);
+    return p < end;
+}
+
+/** a statement handle freed when it goes out of scope */
+struct StatementHandle
+{
+    FbApiHandle handle_;
+
+    explicit StatementHandle(FbApiHandle db) : handle_(0)
+    {
+        ISC_STATUS_ARRAY status;
+        if (isc_dsql_allocate_statement(status, &db, &handle_)) {
+            throw FbException("Failed to allocate statement.", status);
+        }
+    }
+
+    ~StatementHandle()
+    {
+        ISC_STATUS_ARRAY status;
+        isc_dsql_free_statement(status, &handle_, DSQL_drop);
+    }
+
+    StatementHandle(const StatementHandle&) = delete;
+    StatementHandle &operator=(const StatementHandle&) = delete;
+};
+
+/**
+ * add the names of the relations selected by sql to names, it's run
+ * through the API directly so the statement wrappers don't record it
+ */
+static void readRelationNames(FbApiHandle db, FbApiHandle transaction,
+                              const std::string &sql,
+                              std::unordered_map<unsigned int, std::string> &names)
+{
+    StatementHandle st(db);
+
+    std::unique_ptr<char[]> sqldaBuffer(new char[XSQLDA_LENGTH(2)]);
+    memset(sqldaBuffer.get(), 0, XSQLDA_LENGTH(2));
+    SqlDescriptorArea *sqlda = reinterpret_cast<SqlDescriptorArea*>(sqldaBuffer.get());
+    sqlda->version = SQLDA_VERSION1;
+    sqlda->sqln = 2;
+
+    ISC_STATUS_ARRAY status;
+    if (isc_dsql_prepare(status, &transaction, &st.handle_, 0, sql.c_str(),
+                         static_cast<short>(FB_SQL_DIALECT), sqlda)) {
+        throw FbException("Failed to prepare the relation names query.", status);
+    }
+    if (sqlda->sqld != 2) {
+        throw FbException("Unexpected relation names query columns.", nullptr);
+    }
+    std::unique_ptr<unsigned char[]> fields(allocateAndSetXsqldaFields(sqlda));
+
+    if (isc_dsql_execute(status, &transaction, &st.handle_, 1, nullptr)) {
+        throw FbException("Failed to read the relation names.", status);
+    }
+
+    const DbRowProxy row = makeRowProxy(sqlda);
+    ISC_STATUS rc;
+    while ((rc = isc_dsql_fetch(status, &st.handle_, 1, sqlda)) == 0) {
+        names[static_cast<unsigned int>(row.getInt(0))] = row.getText(1);
+    }
+    if (rc != 100) {
+        throw FbException("Failed to read the relation names.", status);
+    }
+}
+
+} /* anonymous namespace */
+
+void nameTables(FbApiHandle db, FbApiHandle transaction,
+                std::unordered_map<unsigned int, std::string> &names,
+                std::vector<DbTableReads> &tables)
+{
+    // the ids not looked up yet, at most MAX_IDS in an IN list
+    const size_t MAX_IDS = 500;
+    std::vector<unsigned int> missing;
+    for (const auto &t : tables) {
+        if (names.find(t.relationId_) == names.end()) {
+            missing.push_back(t.relationId_);
+        }
+    }
+
+    for (size_t first = 0; first < missing.size(); first += MAX_IDS) {
+        const size_t last = std::min(first + MAX_IDS, missing.size());
+        std::string sql = "SELECT RDB$RELATION_ID, TRIM(RDB$RELATION_NAME) "
+                          "FROM RDB$RELATIONS WHERE RDB$RELATION_ID IN (";
+        for (size_t i = first; i != last; ++i) {
+            if (i != first) {
+                sql += ", ";
+            }
+            sql += std::to_string(missing[i]);
+        }
+        sql += ')';
+        readRelationNames(db, transaction, sql, names);
+    }
+    for (unsigned int id : missing) {
+        // not a relation, don't look it up again
+        names.emplace(id, std::string());
+    }
+
+    for (auto &t : tables) {
+        t.table_ = names[t.relationId_];
+    }
+}
+
+DbExecutionStats::DbExecutionStats() : selected_(0),
+                                       inserted_(0),
+                                       updated_(0),
+                                       deleted_(0),
+                                       pageReads_(0),
+                                       pageWrites_(0),
+                                       pageFetches_(0),
+                                       pageMarks_(0),
+                                       tables_()
+{
+}
+
+uint64_t DbExecutionStats::sequentialReads() const
+{
+    uint64_t n = 0;
+    for (const auto &t : tables_) {
+        n += t.sequential_;
+    }
+    return n;
+}
+
+uint64_t DbExecutionStats::indexedReads() const
+{
+    uint64_t n = 0;
+    for (const auto &t : tables_) {
+        n += t.indexed_;
+    }
+    return n;
+}
+
+void readDatabaseCounters(FbApiHandle db, std::vector<char> &reply,
+                          DatabaseCounters &counters)
+{
+    const char request[] = {
+        isc_info_reads, isc_info_writes, isc_info_fetches, isc_info_marks,
+        isc_info_read_seq_count, isc_info_read_idx_count, isc_info_end
+    };
+    if (reply.size() < 4096) {
+        reply.resize(4096);
+    }
+
+    while (true) {
+        ISC_STATUS_ARRAY status;
+        if (isc_database_info(status, &db, sizeof(request), request,
+                              static_cast<short>(reply.size()), &reply[0])) {
+            throw FbException("Failed to read the database counters.", status);
+        }
+
+        // the items that fit come first, isc_info_truncated marks where
+        // the reply was cut, so keep what's complete if it can't grow
+        if (parseDatabaseCounters(reply, counters) || reply.size() >= SHRT_MAX) {
+            break;
+        }
+        reply.resize(std::min<size_t>(reply.size() * 4, SHRT_MAX));
+    }
+}
+
+void readStatementRecords(FbApiHandle statement, DbExecutionStats &stats)
+{
+    const char request[] = { isc_info_sql_records, isc_info_end };
+    char reply[64];
+
+    ISC_STATUS_ARRAY status;
+    if (isc_dsql_sql_info(status, &statement, sizeof(request), request,
+                          sizeof(reply), reply)) {
+        throw FbException("Failed to read the statement record counts.", status);
+    }
+    if (reply[0] != isc_info_sql_records) {
+        return;
+    }
+
+    const char *p = reply + 3;
+    const char *end = reply + sizeof(reply);
+    while (p + 3 <= end && *p != isc_info_end) {
+        const char item = *p;
+        size_t length = static_cast<size_t>(portableInt(p + 1, 2));
+        p += 3;
+        if (p + length > end) {
+            break;
+        }
+
+        uint64_t value = portableInt(p, length);
+        switch (item) {
+        case isc_info_req_select_count:
+            stats.selected_ = value;
+            break;
+        case isc_info_req_insert_count:
+            stats.inserted_ = value;
+            break;
+        case isc_info_req_update_count:
+            stats.updated_ = value;
+            break;
+        case isc_info_req_delete_count:
+            stats.deleted_ = value;
+            break;
+        default:
+            break;
+        }
+        p += length;
+    }
+}
+
+} /* namespace fb */
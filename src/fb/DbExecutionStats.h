@@ -0,0 +1,76 @@
+/*
+ * DbExecutionStats.h - server side cost of a statement execution
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBEXECUTIONSTATS_H_
+#define DBWRAP_FB_SRC_FB_DBEXECUTIONSTATS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace fb
+{
+
+/** the records read from one table */
+struct DbTableReads
+{
+    unsigned int relationId_;
+    std::string table_;
+    /** records read by natural (full) scans */
+    uint64_t sequential_;
+    /** records read through an index */
+    uint64_t indexed_;
+};
+
+/**
+ * What an execution of a statement cost on the server, see
+ * DbStatement::setCollectStats.
+ *
+ * The record counts are those of the statement (isc_info_sql_records).
+ * The page and table counters are the difference of the attachment's
+ * counters (isc_database_info) since the execution started, so they
+ * include the work of other statements run on the same connection
+ * meanwhile.
+ */
+struct DbExecutionStats
+{
+    uint64_t selected_;
+    uint64_t inserted_;
+    uint64_t updated_;
+    uint64_t deleted_;
+
+    /** pages read from disk */
+    uint64_t pageReads_;
+    /** pages written to disk */
+    uint64_t pageWrites_;
+    /** pages read from the page cache */
+    uint64_t pageFetches_;
+    /** pages changed in the page cache */
+    uint64_t pageMarks_;
+
+    /** the tables read, by relation id */
+    std::vector<DbTableReads> tables_;
+
+    DbExecutionStats();
+
+    /** records read by natural scans, of all tables */
+    uint64_t sequentialReads() const;
+    /** records read through indexes, of all tables */
+    uint64_t indexedReads() const;
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBEXECUTIONSTATS_H_ */
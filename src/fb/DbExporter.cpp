@@ -0,0 +1,737 @@
+/*
+ * DbExporter.cpp - stream query results to CSV or binary row files
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbExporter.h"
+
+#include "DbConnection.h"
+#include "DbStatement.h"
+#include "DbTransaction.h"
+#include "FbInternals.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef DBWRAP_FB_ZLIB
+#include <zlib.h>
+#endif
+
+
+namespace fb
+{
+
+namespace {
+
+static void writeAll(int fd, const char *data, size_t size)
+{
+    while (size != 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Failed to write the export: ") +
+                                     strerror(errno));
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+/**
+ * The output buffer of an export. Full buffers are written to the file,
+ * or handed over to a compression thread which gzips and writes them
+ * while the next buffer is being filled.
+ */
+class OutputSink
+{
+public:
+    OutputSink(int fd, const DbExportOptions &opts) :
+                            fd_(fd),
+                            compress_(opts.compress_),
+                            level_(opts.compressionLevel_),
+                            bufferSize_(std::max<size_t>(opts.bufferSize_, 1 << 16)),
+                            buffer_(bufferSize_),
+                            used_(0),
+                            mutex_(),
+                            changed_(),
+                            pending_(),
+                            spare_(),
+                            done_(false),
+                            error_(),
+                            thread_()
+    {
+#ifdef DBWRAP_FB_ZLIB
+        if (compress_) {
+            thread_ = std::thread(&OutputSink::compressLoop, this);
+        }
+#else
+        if (compress_) {
+            throw std::logic_error("The library was built without zlib, "
+                                   "compressed exports are not available!");
+        }
+#endif
+    }
+
+    ~OutputSink()
+    {
+        stopCompressor();
+    }
+
+    /** room for at least n more bytes */
+    char *reserve(size_t n)
+    {
+        if (buffer_.size() - used_ < n) {
+            flush();
+            if (buffer_.size() < n) {
+                buffer_.resize(n);
+            }
+        }
+        return &buffer_[used_];
+    }
+
+    void commit(size_t n)
+    {
+        used_ += n;
+    }
+
+    void append(const void *data, size_t n)
+    {
+        memcpy(reserve(n), data, n);
+        commit(n);
+    }
+
+    /** write everything, the sink can't be used afterwards */
+    void finish()
+    {
+        flush();
+        stopCompressor();
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+private:
+    OutputSink(const OutputSink&) = delete;
+    OutputSink &operator=(const OutputSink&) = delete;
+
+    void flush()
+    {
+        if (used_ == 0) {
+            return;
+        }
+
+        if (!compress_) {
+            writeAll(fd_, buffer_.data(), used_);
+            used_ = 0;
+            return;
+        }
+
+        std::unique_lock<std::mutex> lk(mutex_);
+        // double buffering, wait while the compressor is behind
+        changed_.wait(lk, [this] { return error_ || pending_.size() < 2; });
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        pending_.emplace_back(std::move(buffer_), used_);
+        if (spare_.empty()) {
+            buffer_.assign(bufferSize_, '\0');
+        } else {
+            buffer_ = std::move(spare_.back());
+            spare_.pop_back();
+        }
+        used_ = 0;
+        lk.unlock();
+        changed_.notify_all();
+    }
+
+    void stopCompressor()
+    {
+        if (thread_.joinable()) {
+            {
+                std::lock_guard<std::mutex> const lg(mutex_);
+                done_ = true;
+            }
+            changed_.notify_all();
+            thread_.join();
+        }
+    }
+
+#ifdef DBWRAP_FB_ZLIB
+    void compressLoop()
+    {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        // 16 + MAX_WBITS writes a gzip header
+        if (deflateInit2(&zs, level_, Z_DEFLATED, 16 + MAX_WBITS, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            std::lock_guard<std::mutex> const lg(mutex_);
+            error_ = std::make_exception_ptr(
+                    std::runtime_error("Failed to initialize the compression!"));
+            changed_.notify_all();
+            return;
+        }
+
+        std::vector<char> out(bufferSize_);
+        try {
+            while (true) {
+                std::pair<std::vector<char>, size_t> chunk;
+                {
+                    std::unique_lock<std::mutex> lk(mutex_);
+                    changed_.wait(lk, [this] { return done_ || !pending_.empty(); });
+                    if (pending_.empty()) {
+                        break;
+                    }
+                    chunk = std::move(pending_.front());
+                    pending_.pop_front();
+                }
+                changed_.notify_all();
+
+                zs.next_in = reinterpret_cast<Bytef*>(chunk.first.data());
+                zs.avail_in = static_cast<uInt>(chunk.second);
+                deflateChunk(zs, out, Z_NO_FLUSH);
+
+                std::lock_guard<std::mutex> const lg(mutex_);
+                spare_.push_back(std::move(chunk.first));
+            }
+            deflateChunk(zs, out, Z_FINISH);
+        } catch (...) {
+            std::lock_guard<std::mutex> const lg(mutex_);
+            error_ = std::current_exception();
+        }
+        deflateEnd(&zs);
+        changed_.notify_all();
+    }
+
+    void deflateChunk(z_stream &zs, std::vector<char> &out, int flush)
+    {
+        int rc;
+        do {
+            zs.next_out = reinterpret_cast<Bytef*>(out.data());
+            zs.avail_out = static_cast<uInt>(out.size());
+            rc = deflate(&zs, flush);
+            if (rc == Z_STREAM_ERROR) {
+                throw std::runtime_error("Failed to compress the export!");
+            }
+            writeAll(fd_, out.data(), out.size() - zs.avail_out);
+        } while (zs.avail_out == 0 || (flush == Z_FINISH && rc != Z_STREAM_END));
+    }
+#endif
+
+    int fd_;
+    bool compress_;
+    int level_;
+    size_t bufferSize_;
+    std::vector<char> buffer_;
+    size_t used_;
+
+    // hand over of full buffers to the compression thread
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<std::pair<std::vector<char>, size_t>> pending_;
+    std::vector<std::vector<char>> spare_;
+    bool done_;
+    std::exception_ptr error_;
+    std::thread thread_;
+};
+
+static bool isExportableType(const XSQLVAR &v1)
+{
+    switch (v1.sqltype & ~1) {
+    case SQL_TEXT:
+    case SQL_VARYING:
+    case SQL_SHORT:
+    case SQL_LONG:
+    case SQL_INT64:
+    case SQL_FLOAT:
+    case SQL_DOUBLE:
+    case SQL_D_FLOAT:
+    case SQL_TIMESTAMP:
+    case SQL_TYPE_DATE:
+    case SQL_TYPE_TIME:
+#ifdef SQL_BOOLEAN
+    case SQL_BOOLEAN:
+#endif
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool isNull(const XSQLVAR &v1)
+{
+    return (v1.sqltype & 1) && *v1.sqlind < 0;
+}
+
+/** the value bytes of a text field, CHAR values without their padding */
+static void textValue(const XSQLVAR &v1, const char *&data, size_t &length)
+{
+    if ((v1.sqltype & ~1) == SQL_VARYING) {
+        const FbVarchar *vc = reinterpret_cast<const FbVarchar*>(v1.sqldata);
+        data = vc->str;
+        length = static_cast<size_t>(vc->length);
+    } else {
+        data = v1.sqldata;
+        length = static_cast<size_t>(v1.sqllen);
+        while (length != 0 && data[length - 1] == ' ') {
+            --length;
+        }
+    }
+}
+
+static char *writeDigits(char *p, unsigned int value, int width)
+{
+    for (int i = width - 1; i >= 0; --i) {
+        p[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return p + width;
+}
+
+static char *writeDate(char *p, const struct tm &t)
+{
+    p = writeDigits(p, static_cast<unsigned int>(t.tm_year + 1900), 4);
+    *p++ = '-';
+    p = writeDigits(p, static_cast<unsigned int>(t.tm_mon + 1), 2);
+    *p++ = '-';
+    return writeDigits(p, static_cast<unsigned int>(t.tm_mday), 2);
+}
+
+static char *writeTime(char *p, const struct tm &t, ISC_TIME fraction)
+{
+    p = writeDigits(p, static_cast<unsigned int>(t.tm_hour), 2);
+    *p++ = ':';
+    p = writeDigits(p, static_cast<unsigned int>(t.tm_min), 2);
+    *p++ = ':';
+    p = writeDigits(p, static_cast<unsigned int>(t.tm_sec), 2);
+    *p++ = '.';
+    return writeDigits(p, fraction, 4);
+}
+
+/** the longest text of a value of v1 in a CSV line */
+static size_t csvFieldSize(const XSQLVAR &v1)
+{
+    switch (v1.sqltype & ~1) {
+    case SQL_TEXT:
+    case SQL_VARYING:
+        // every character quoted, plus the quotes
+        return 2 * static_cast<size_t>(v1.sqllen) + 2;
+    default:
+        return 32;
+    }
+}
+
+static char *writeCsvField(char *p, const XSQLVAR &v1, char delimiter)
+{
+    if (isNull(v1)) {
+        return p;
+    }
+
+    const char *text;
+    size_t length;
+    struct tm t;
+    ISC_TIME time;
+    const ISC_TIMESTAMP *ts;
+    bool quote;
+
+    switch (v1.sqltype & ~1) {
+    case SQL_TEXT:
+    case SQL_VARYING:
+        textValue(v1, text, length);
+        // an empty string is quoted, an empty field is NULL
+        quote = (length == 0);
+        for (size_t i = 0; i != length && !quote; ++i) {
+            const char c = text[i];
+            quote = (c == delimiter || c == '"' || c == '\n' || c == '\r');
+        }
+        if (!quote) {
+            memcpy(p, text, length);
+            return p + length;
+        }
+        *p++ = '"';
+        for (size_t i = 0; i != length; ++i) {
+            if (text[i] == '"') {
+                *p++ = '"';
+            }
+            *p++ = text[i];
+        }
+        *p++ = '"';
+        return p;
+    case SQL_SHORT:
+        return formatScaledInt(p, *reinterpret_cast<const ISC_SHORT*>(v1.sqldata),
+                               v1.sqlscale);
+    case SQL_LONG:
+        return formatScaledInt(p, *reinterpret_cast<const ISC_LONG*>(v1.sqldata),
+                               v1.sqlscale);
+    case SQL_INT64:
+        return formatScaledInt(p, *reinterpret_cast<const ISC_INT64*>(v1.sqldata),
+                               v1.sqlscale);
+    case SQL_FLOAT:
+        // the shortest text that reads back as the same value
+        return p + snprintf(p, 32, "%.9g",
+                            static_cast<double>(*reinterpret_cast<const float*>(v1.sqldata)));
+    case SQL_DOUBLE:
+    case SQL_D_FLOAT:
+        return p + snprintf(p, 32, "%.17g", *reinterpret_cast<const double*>(v1.sqldata));
+    case SQL_TYPE_DATE:
+        isc_decode_sql_date(reinterpret_cast<const ISC_DATE*>(v1.sqldata), &t);
+        return writeDate(p, t);
+    case SQL_TYPE_TIME:
+        time = *reinterpret_cast<const ISC_TIME*>(v1.sqldata);
+        isc_decode_sql_time(&time, &t);
+        return writeTime(p, t, time % 10000);
+    case SQL_TIMESTAMP:
+        ts = reinterpret_cast<const ISC_TIMESTAMP*>(v1.sqldata);
+        isc_decode_timestamp(ts, &t);
+        p = writeDate(p, t);
+        *p++ = ' ';
+        return writeTime(p, t, ts->timestamp_time % 10000);
+    default:
+        // boolean
+        if (*reinterpret_cast<const unsigned char*>(v1.sqldata)) {
+            memcpy(p, "true", 4);
+            return p + 4;
+        }
+        memcpy(p, "false", 5);
+        return p + 5;
+    }
+}
+
+static void writeCsvHeader(OutputSink &out, const XSQLDA *sqlda, char delimiter)
+{
+    for (int i = 0; i != sqlda->sqld; ++i) {
+        const XSQLVAR &v1 = sqlda->sqlvar[i];
+        if (i != 0) {
+            out.append(&delimiter, 1);
+        }
+        out.append(v1.aliasname, static_cast<size_t>(v1.aliasname_length));
+    }
+    out.append("\n", 1);
+}
+
+template <typename T>
+static char *writeBinary(char *p, T value)
+{
+    memcpy(p, &value, sizeof(value));
+    return p + sizeof(value);
+}
+
+static void writeBinaryHeader(OutputSink &out, const XSQLDA *sqlda)
+{
+    out.append(BINARY_ROWS_MAGIC, BINARY_ROWS_MAGIC_LENGTH);
+    char *p = out.reserve(sizeof(uint16_t));
+    out.commit(static_cast<size_t>(
+            writeBinary(p, static_cast<uint16_t>(sqlda->sqld)) - p));
+
+    for (int i = 0; i != sqlda->sqld; ++i) {
+        const XSQLVAR &v1 = sqlda->sqlvar[i];
+        int length = v1.sqllen;
+        if ((v1.sqltype & ~1) == SQL_VARYING) {
+            // the field buffer holds the length prefix too
+            length -= static_cast<int>(sizeof(ISC_SHORT));
+        }
+        const uint8_t nameLength = static_cast<uint8_t>(v1.aliasname_length);
+
+        p = out.reserve(7 + nameLength);
+        char *q = writeBinary(p, static_cast<int16_t>(v1.sqltype & ~1));
+        q = writeBinary(q, static_cast<int16_t>(v1.sqlscale));
+        q = writeBinary(q, static_cast<uint16_t>(length));
+        q = writeBinary(q, nameLength);
+        memcpy(q, v1.aliasname, nameLength);
+        out.commit(static_cast<size_t>(q - p) + nameLength);
+    }
+}
+
+static char *writeBinaryRow(char *p, const XSQLDA *sqlda)
+{
+    char *start = p;
+    p += sizeof(uint32_t);
+
+    for (int i = 0; i != sqlda->sqld; ++i) {
+        const XSQLVAR &v1 = sqlda->sqlvar[i];
+        if (isNull(v1)) {
+            *p++ = 1;
+            continue;
+        }
+        *p++ = 0;
+
+        const int type = v1.sqltype & ~1;
+        if (type == SQL_TEXT || type == SQL_VARYING) {
+            const char *data = v1.sqldata;
+            size_t length = static_cast<size_t>(v1.sqllen);
+            if (type == SQL_VARYING) {
+                textValue(v1, data, length);
+            }
+            p = writeBinary(p, static_cast<uint16_t>(length));
+            memcpy(p, data, length);
+            p += length;
+        } else {
+            memcpy(p, v1.sqldata, static_cast<size_t>(v1.sqllen));
+            p += v1.sqllen;
+        }
+    }
+
+    writeBinary(start, static_cast<uint32_t>(p - start - sizeof(uint32_t)));
+    return p;
+}
+
+static size_t binaryRowSize(const XSQLDA *sqlda)
+{
+    size_t size = sizeof(uint32_t);
+    for (int i = 0; i != sqlda->sqld; ++i) {
+        size += 1 + sizeof(uint16_t) + static_cast<size_t>(sqlda->sqlvar[i].sqllen);
+    }
+    return size;
+}
+
+/** the SELECT of a whole table, its name is quoted so it's used as is */
+static std::string selectTableSql(const std::string &table)
+{
+    std::string sql = "SELECT * FROM \"";
+    for (char c : table) {
+        if (c == '"') {
+            sql += '"';
+        }
+        sql += c;
+    }
+    sql += '"';
+    return sql;
+}
+
+/**
+ * the file name of a table's dump, the characters other than letters,
+ * digits, '_' and '$' are replaced so it can't leave the directory
+ */
+static std::string tableFileName(const std::string &table)
+{
+    std::string name = table;
+    for (char &c : name) {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '$') {
+            c = '_';
+        }
+    }
+    return name;
+}
+
+} /* anonymous namespace */
+
+DbExporter::DbExporter(const DbExportOptions &opts /* = DbExportOptions() */) :
+        opts_(opts)
+{
+}
+
+uint64_t DbExporter::exportRows(DbStatement &st, int fd)
+{
+    const XSQLDA *sqlda = st.results_;
+    if (!sqlda) {
+        throw std::invalid_argument("The statement doesn't return rows!");
+    }
+
+    for (int i = 0; i != sqlda->sqld; ++i) {
+        if (!isExportableType(sqlda->sqlvar[i])) {
+            throw std::invalid_argument("The exporter doesn't support the type "
+                                        "of column " + std::to_string(i + 1));
+        }
+    }
+
+    OutputSink out(fd, opts_);
+    const bool csv = (opts_.format_ == DbExportFormat::Csv);
+    size_t rowSize;
+    if (csv) {
+        rowSize = 1;
+        for (int i = 0; i != sqlda->sqld; ++i) {
+            rowSize += csvFieldSize(sqlda->sqlvar[i]) + 1;
+        }
+        if (opts_.header_) {
+            writeCsvHeader(out, sqlda, opts_.delimiter_);
+        }
+    } else {
+        rowSize = binaryRowSize(sqlda);
+        writeBinaryHeader(out, sqlda);
+    }
+
+    uint64_t rows = 0;
+    for (auto it = st.iterate(); it != st.end(); ++it) {
+        char *start = out.reserve(rowSize);
+        char *p = start;
+        if (csv) {
+            for (int i = 0; i != sqlda->sqld; ++i) {
+                if (i != 0) {
+                    *p++ = opts_.delimiter_;
+                }
+                p = writeCsvField(p, sqlda->sqlvar[i], opts_.delimiter_);
+            }
+            *p++ = '\n';
+        } else {
+            p = writeBinaryRow(p, sqlda);
+        }
+        out.commit(static_cast<size_t>(p - start));
+        ++rows;
+    }
+
+    out.finish();
+    return rows;
+}
+
+uint64_t DbExporter::exportQuery(DbConnection &connection,
+                                 const char *sql,
+                                 const char *fileName,
+                                 DbTransaction *tr /* = nullptr */)
+{
+    if (!sql || !fileName) {
+        throw std::invalid_argument("invalid export arguments!");
+    }
+
+    std::unique_ptr<DbTransaction> ownTransaction;
+    if (!tr) {
+        ownTransaction.reset(new DbTransaction(connection.nativeHandle(), 1,
+                                               DefaultTransMode::Commit,
+                                               TransStartMode::DeferStart));
+        ownTransaction->startSnapshot();
+        tr = ownTransaction.get();
+    }
+
+    int fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("Failed to create ") + fileName +
+                                 ": " + strerror(errno));
+    }
+
+    uint64_t rows;
+    try {
+        DbStatement st = connection.createStatement(sql, tr);
+        rows = exportRows(st, fd);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+
+    if (close(fd) != 0) {
+        throw std::runtime_error(std::string("Failed to write ") + fileName +
+                                 ": " + strerror(errno));
+    }
+    return rows;
+}
+
+uint64_t DbExporter::dumpTables(DbConnection *const *connections,
+                                unsigned int connCount,
+                                const std::vector<std::string> &tables,
+                                const char *directory)
+{
+    if (connCount == 0 || !directory) {
+        throw std::invalid_argument("invalid dump arguments!");
+    }
+
+    std::vector<std::string> fileNames;
+    for (const auto &table : tables) {
+        if (table.empty() || table.find('\0') != std::string::npos) {
+            throw std::invalid_argument("invalid table name!");
+        }
+        fileNames.push_back(tableFileName(table));
+        if (std::count(fileNames.begin(), fileNames.end(), fileNames.back()) != 1) {
+            throw std::invalid_argument("two tables would be dumped to " +
+                                        fileNames.back() + "!");
+        }
+    }
+
+    // the snapshot shared by all tables, it must stay active until all
+    // the exports started their transactions
+    DbTransaction source(connections[0]->nativeHandle(), 1,
+                         DefaultTransMode::Commit,
+                         TransStartMode::DeferStart);
+    source.startSnapshot();
+    int64_t snapshotNumber;
+    try {
+        snapshotNumber = source.snapshotNumber();
+    } catch (std::exception &) {
+        // the client library or the server can't share snapshots
+        snapshotNumber = 0;
+    }
+
+    std::string suffix = (opts_.format_ == DbExportFormat::Csv) ? ".csv" : ".bin";
+    if (opts_.compress_) {
+        suffix += ".gz";
+    }
+
+    std::atomic<size_t> nextTable(0);
+    std::atomic<uint64_t> rows(0);
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    auto worker = [&](DbConnection *connection) {
+        try {
+            for (size_t t = nextTable++; t < tables.size(); t = nextTable++) {
+                DbTransaction tr(connection->nativeHandle(), 1,
+                                 DefaultTransMode::Commit,
+                                 TransStartMode::DeferStart);
+                if (snapshotNumber != 0) {
+                    tr.startAtSnapshot(snapshotNumber);
+                } else {
+                    tr.startSnapshot();
+                }
+
+                const std::string sql = selectTableSql(tables[t]);
+                const std::string path = std::string(directory) + "/" +
+                                         fileNames[t] + suffix;
+                rows += exportQuery(*connection, sql.c_str(), path.c_str(), &tr);
+            }
+        } catch (...) {
+            // let the other workers stop after their current table
+            nextTable = tables.size();
+            std::lock_guard<std::mutex> const lg(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    try {
+        for (unsigned int c = 0; c != connCount; ++c) {
+            threads.emplace_back(worker, connections[c]);
+        }
+    } catch (...) {
+        nextTable = tables.size();
+        for (auto &t : threads) {
+            t.join();
+        }
+        throw;
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return rows;
+}
+
+} /* namespace fb */
@@ -0,0 +1,119 @@
+/*
+ * DbExporter.h - stream query results to CSV or binary row files
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBEXPORTER_H_
+#define DBWRAP_FB_SRC_FB_DBEXPORTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace fb
+{
+
+// forward declarations
+class DbConnection;
+class DbStatement;
+class DbTransaction;
+
+enum class DbExportFormat
+{
+    /** RFC 4180 like text, NULL is an empty field, '' is "" */
+    Csv,
+    /** length prefixed rows, see BINARY_ROWS_MAGIC in FbInternals.h */
+    Binary
+};
+
+struct DbExportOptions
+{
+    DbExportFormat format_;
+    /** CSV field delimiter */
+    char delimiter_;
+    /** write the column names as the first CSV line */
+    bool header_;
+    /** output is written in chunks of this size */
+    size_t bufferSize_;
+    /**
+     * gzip the output on a separate thread, needs a library built with
+     * zlib (make ZLIB=1)
+     */
+    bool compress_;
+    int compressionLevel_;
+
+    explicit DbExportOptions(DbExportFormat format = DbExportFormat::Csv,
+                             char delimiter = ',')
+              : format_(format),
+                delimiter_(delimiter),
+                header_(false),
+                bufferSize_(1 << 20),
+                compress_(false),
+                compressionLevel_(1)
+    {
+    }
+};
+
+/**
+ * Writes the rows of a SELECT to a file descriptor. Values are
+ * formatted straight from the statement's result buffers into a large
+ * output buffer, there are no allocations per row or field. Exact
+ * numerics are written with their scale, timestamps as
+ * "YYYY-MM-DD HH:MM:SS.ffff". Blob and array columns are not supported.
+ */
+class DbExporter
+{
+public:
+    explicit DbExporter(const DbExportOptions &opts = DbExportOptions());
+
+    /**
+     * execute the prepared SELECT and write its rows to fd
+     * \return the number of rows written
+     */
+    uint64_t exportRows(DbStatement &st, int fd);
+
+    /**
+     * run sql in tr (in a new read-only snapshot transaction if tr is
+     * null) and write the rows to a new file
+     */
+    uint64_t exportQuery(DbConnection &connection,
+                         const char *sql,
+                         const char *fileName,
+                         DbTransaction *tr = nullptr);
+
+    /**
+     * Dump whole tables, one file per table named after it (".csv" or
+     * ".bin", plus ".gz" if compressed) in directory. The tables are
+     * spread over the connections, one thread each, and all of them are
+     * read at the same snapshot when the server supports shared
+     * snapshots (see DbTransaction::startAtSnapshot).
+     *
+     * The table names are used as stored, in upper case unless the
+     * table was created with a quoted name. In the file names the
+     * characters other than letters, digits, '_' and '$' become '_',
+     * std::invalid_argument is thrown if two tables get the same one.
+     * \return the number of rows written
+     */
+    uint64_t dumpTables(DbConnection *const *connections,
+                        unsigned int connCount,
+                        const std::vector<std::string> &tables,
+                        const char *directory);
+
+private:
+    DbExportOptions opts_;
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBEXPORTER_H_ */
@@ -0,0 +1,205 @@
+/*
+ * DbInListStatement.cpp - bind a list of values to a single "IN (?...)"
+ *                         placeholder while preparing few statements
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbInListStatement.h"
+
+#include "DbConnection.h"
+#include "DbStaging.h"
+#include "DbTransaction.h"
+#include "FbInternals.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace fb
+{
+
+constexpr unsigned int DbInListStatement::MAX_TEXT_LENGTH;
+
+namespace {
+
+const char LIST_PLACEHOLDER[] = "?...";
+
+} /* anonymous namespace */
+
+DbInListStatement::DbInListStatement(DbConnection &connection,
+                                     DbTransaction &transaction,
+                                     const char *sql,
+                                     unsigned int maxInlineValues) :
+                                        connection_(connection),
+                                        transaction_(transaction),
+                                        sqlHead_(),
+                                        sqlTail_(),
+                                        paramsBefore_(0),
+                                        maxInlineValues_(std::max(maxInlineValues, 1u)),
+                                        textList_(false),
+                                        list_(),
+                                        params_(),
+                                        shapes_(),
+                                        stagedShapes_(),
+                                        stagings_()
+{
+    if (!sql) {
+        throw std::invalid_argument("null SQL statement!");
+    }
+
+    const char *marker = nullptr;
+    for (const char *p = sql; *p; ) {
+        const char *next = skipLiteralOrComment(p);
+        if (next != p) {
+            p = next;
+        } else if (strncmp(p, LIST_PLACEHOLDER, sizeof(LIST_PLACEHOLDER) - 1) == 0) {
+            if (marker) {
+                throw std::invalid_argument("only one list placeholder is supported!");
+            }
+            marker = p;
+            p += sizeof(LIST_PLACEHOLDER) - 1;
+        } else {
+            if (*p == '?' && !marker) {
+                ++paramsBefore_;
+            }
+            ++p;
+        }
+    }
+
+    if (!marker) {
+        throw std::invalid_argument("statement has no list placeholder!");
+    }
+
+    sqlHead_.assign(sql, static_cast<size_t>(marker - sql));
+    sqlTail_.assign(marker + sizeof(LIST_PLACEHOLDER) - 1);
+}
+
+DbInListStatement::~DbInListStatement()
+{
+}
+
+void DbInListStatement::setList(const std::vector<int64_t> &values)
+{
+    textList_ = false;
+    list_.assign(values.begin(), values.end());
+}
+
+void DbInListStatement::setList(const std::vector<std::string> &values)
+{
+    for (const auto &v : values) {
+        if (v.size() > MAX_TEXT_LENGTH) {
+            throw std::invalid_argument("list value is too long!");
+        }
+    }
+    textList_ = true;
+    list_.assign(values.begin(), values.end());
+}
+
+void DbInListStatement::setParam(unsigned int idx, const DbParam &value)
+{
+    if (idx == 0) {
+        throw std::out_of_range("statement parameter index is out of range!");
+    }
+
+    if (params_.size() < idx) {
+        params_.resize(idx);
+    }
+    params_[idx - 1] = value;
+}
+
+DbStatement &DbInListStatement::shape(unsigned int arity)
+{
+    auto i = shapes_.find(arity);
+    if (i == shapes_.end()) {
+        std::string sql = sqlHead_;
+        for (unsigned int n = 0; n != arity; ++n) {
+            sql += n ? ", ?" : "?";
+        }
+        sql += sqlTail_;
+        i = shapes_.emplace(arity,
+                connection_.createStatement(sql.c_str(), &transaction_)).first;
+    }
+    return i->second;
+}
+
+DbStaging &DbInListStatement::staging()
+{
+    std::unique_ptr<DbStaging> &staging = stagings_[textList_];
+    if (!staging) {
+        staging.reset(new DbStaging(connection_, transaction_,
+                                    textList_ ? "V VARCHAR(255)" : "V BIGINT"));
+    }
+    return *staging;
+}
+
+DbStatement &DbInListStatement::stagedShape()
+{
+    auto i = stagedShapes_.find(textList_);
+    if (i == stagedShapes_.end()) {
+        std::string sql = sqlHead_;
+        sql += "SELECT V FROM ";
+        sql += staging().tableName();
+        sql += sqlTail_;
+        i = stagedShapes_.emplace(textList_,
+                connection_.createStatement(sql.c_str(), &transaction_)).first;
+    }
+    return i->second;
+}
+
+DbStatement &DbInListStatement::bind()
+{
+    const size_t count = list_.size();
+    DbStatement *st;
+    unsigned int arity = 0;
+
+    if (count > maxInlineValues_) {
+        st = &stagedShape();
+        st->reset();
+
+        // rows of a previous list in the same transaction are still there
+        DbStaging &stage = staging();
+        stage.clear();
+        for (const auto &v : list_) {
+            stage.add(std::vector<DbParam>(1, v));
+        }
+    } else {
+        // round up to a power of two, an empty list is a single NULL
+        // which matches nothing
+        arity = 1;
+        while (arity < count) {
+            arity <<= 1;
+        }
+        arity = std::min(arity, maxInlineValues_);
+
+        st = &shape(arity);
+        st->reset();
+
+        const DbParam nullValue;
+        for (unsigned int n = 0; n != arity; ++n) {
+            const DbParam &v = count ? list_[std::min<size_t>(n, count - 1)]
+                                     : nullValue;
+            v.bind(*st, paramsBefore_ + n + 1);
+        }
+    }
+
+    for (size_t k = 1; k <= params_.size(); ++k) {
+        unsigned int idx = static_cast<unsigned int>(k);
+        if (idx > paramsBefore_) {
+            idx += arity;
+        }
+        params_[k - 1].bind(*st, idx);
+    }
+    return *st;
+}
+
+} /* namespace fb */
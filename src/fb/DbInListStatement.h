@@ -0,0 +1,106 @@
+/*
+ * DbInListStatement.h - bind a list of values to a single "IN (?...)"
+ *                       placeholder while preparing few statements
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBINLISTSTATEMENT_H_
+#define DBWRAP_FB_SRC_FB_DBINLISTSTATEMENT_H_
+
+#include "DbParam.h"
+#include "DbStatement.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace fb
+{
+
+// forward declarations
+class DbConnection;
+class DbStaging;
+class DbTransaction;
+
+/**
+ * A statement with one list placeholder "?..." (as in
+ * "WHERE id IN (?...)") bound to a variable number of values.
+ *
+ * The placeholder is expanded to the next power of two number of '?'
+ * parameters and the unused ones repeat the last value, so only a few
+ * statement shapes are ever prepared, each one once. Lists longer than
+ * maxInlineValues are staged (see DbStaging) in the same transaction and
+ * the placeholder becomes a sub-select from the staging table.
+ */
+class DbInListStatement
+{
+public:
+    /** the transaction is not owned and it must be started */
+    DbInListStatement(DbConnection &connection,
+                      DbTransaction &transaction,
+                      const char *sql,
+                      unsigned int maxInlineValues = 256);
+    ~DbInListStatement();
+
+    void setList(const std::vector<int64_t> &values);
+    /** text values longer than MAX_TEXT_LENGTH are not supported */
+    void setList(const std::vector<std::string> &values);
+
+    /**
+     * set one of the other ('?') parameters of the statement,
+     * idx is 1 based and doesn't count the list placeholder
+     */
+    void setParam(unsigned int idx, const DbParam &value);
+
+    /**
+     * prepare (on first use) the statement shape for the current list and
+     * bind all values, the statement is valid until the next call of bind
+     */
+    DbStatement &bind();
+
+    static constexpr unsigned int MAX_TEXT_LENGTH = 255;
+
+private:
+    DbInListStatement(const DbInListStatement&) = delete;
+    DbInListStatement &operator=(const DbInListStatement&) = delete;
+
+    DbStatement &shape(unsigned int arity);
+    DbStaging &staging();
+    DbStatement &stagedShape();
+
+    DbConnection &connection_;
+    DbTransaction &transaction_;
+    /** SQL text before and after the list placeholder */
+    std::string sqlHead_;
+    std::string sqlTail_;
+    /** number of '?' parameters before the list placeholder */
+    unsigned int paramsBefore_;
+    unsigned int maxInlineValues_;
+
+    bool textList_;
+    std::vector<DbParam> list_;
+    std::vector<DbParam> params_;
+
+    /** prepared statements by number of inline values */
+    std::map<unsigned int, DbStatement> shapes_;
+    /** statements selecting from the staging tables, by textList_ */
+    std::map<bool, DbStatement> stagedShapes_;
+    /** staging of long lists, by textList_ */
+    std::map<bool, std::unique_ptr<DbStaging>> stagings_;
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBINLISTSTATEMENT_H_ */
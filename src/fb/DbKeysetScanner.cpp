@@ -0,0 +1,166 @@
+/*
+ * DbKeysetScanner.cpp - stream the rows of a large table in primary key
+ *                       order, one short transaction per chunk of rows
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbKeysetScanner.h"
+
+#include "DbConnection.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+
+namespace fb
+{
+
+namespace {
+
+static std::string chunkSql(const char *table, const char *keyColumn,
+                            const char *columns, unsigned int chunkRows,
+                            bool afterKey)
+{
+    if (!table || !keyColumn || !columns || chunkRows == 0) {
+        throw std::invalid_argument("invalid keyset scan arguments!");
+    }
+
+    std::string sql = "SELECT ";
+    sql.append(keyColumn).append(", ");
+    if (strcmp(columns, "*") == 0) {
+        // "SELECT key, * FROM t" isn't valid SQL, the star must be qualified
+        sql.append(table).append(".*");
+    } else {
+        sql.append(columns);
+    }
+    sql.append(" FROM ").append(table);
+    if (afterKey) {
+        sql.append(" WHERE ").append(keyColumn).append(" > ?");
+    }
+    sql.append(" ORDER BY ").append(keyColumn)
+       .append(" ROWS ").append(std::to_string(chunkRows));
+    return sql;
+}
+
+} /* anonymous namespace */
+
+DbKeysetScanner::DbKeysetScanner(DbConnection &connection,
+                                 const char *table,
+                                 const char *keyColumn,
+                                 const char *columns /* = "*" */,
+                                 unsigned int chunkRows /* = 10000 */) :
+        chunkRows_(chunkRows),
+        // statements are prepared in a transaction, then reused by
+        // the transaction of each chunk
+        transaction_(connection.nativeHandle(), 1,
+                     DefaultTransMode::Commit,
+                     TransStartMode::StartReadOnly),
+        first_(connection.createStatement(
+                chunkSql(table, keyColumn, columns, chunkRows, false).c_str(),
+                &transaction_)),
+        after_(connection.createStatement(
+                chunkSql(table, keyColumn, columns, chunkRows, true).c_str(),
+                &transaction_)),
+        current_(nullptr),
+        it_(),
+        rowsInChunk_(0),
+        chunkCount_(0),
+        hasKey_(false),
+        lastKey_(0),
+        done_(false)
+{
+    transaction_.commit();
+}
+
+DbKeysetScanner::~DbKeysetScanner()
+{
+    try {
+        finishChunk();
+    } catch (...) {
+        // destructors must not throw
+    }
+}
+
+void DbKeysetScanner::resumeAfter(int64_t key)
+{
+    finishChunk();
+    hasKey_ = true;
+    lastKey_ = key;
+    done_ = false;
+}
+
+bool DbKeysetScanner::next()
+{
+    while (!done_) {
+        if (!it_) {
+            // start a new chunk in a new short read-only transaction
+            transaction_.start(true);
+            current_ = hasKey_ ? &after_ : &first_;
+            if (hasKey_) {
+                current_->setInt(1, lastKey_);
+            }
+            rowsInChunk_ = 0;
+            ++chunkCount_;
+            it_.reset(new DbStatement::Iterator(current_->iterate()));
+        } else {
+            ++(*it_);
+        }
+
+        if (*it_ != current_->end()) {
+            lastKey_ = (**it_).getInt64(0);
+            hasKey_ = true;
+            ++rowsInChunk_;
+            return true;
+        }
+
+        // a short chunk is the last one
+        done_ = (rowsInChunk_ < chunkRows_);
+        finishChunk();
+    }
+    return false;
+}
+
+DbRowProxy DbKeysetScanner::row()
+{
+    if (!it_ || !(*it_ != current_->end())) {
+        throw std::logic_error("The keyset scanner has no current row!");
+    }
+    return **it_;
+}
+
+bool DbKeysetScanner::hasCheckpoint() const
+{
+    return hasKey_;
+}
+
+int64_t DbKeysetScanner::checkpoint() const
+{
+    return lastKey_;
+}
+
+uint64_t DbKeysetScanner::chunkCount() const
+{
+    return chunkCount_;
+}
+
+void DbKeysetScanner::finishChunk()
+{
+    it_.reset();
+    if (current_) {
+        current_->reset();
+        current_ = nullptr;
+    }
+    transaction_.commit();
+}
+
+} /* namespace fb */
@@ -0,0 +1,97 @@
+/*
+ * DbKeysetScanner.h - stream the rows of a large table in primary key
+ *                     order, one short transaction per chunk of rows
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBKEYSETSCANNER_H_
+#define DBWRAP_FB_SRC_FB_DBKEYSETSCANNER_H_
+
+#include "DbRowProxy.h"
+#include "DbStatement.h"
+#include "DbTransaction.h"
+
+#include <cstdint>
+#include <memory>
+
+
+namespace fb
+{
+
+// forward declarations
+class DbConnection;
+
+/**
+ * Walks a table by ranges of an integer primary key using a prepared
+ * "WHERE key > ? ORDER BY key ROWS n" statement. Each chunk of rows is
+ * read in its own short read-only transaction, so a scan of a huge
+ * table doesn't keep a transaction open for hours. The caller sees one
+ * continuous stream of rows.
+ *
+ * Rows changed by other transactions between chunks are seen as of the
+ * chunk that reads them.
+ */
+class DbKeysetScanner
+{
+public:
+    /**
+     * table, keyColumn and columns are put in the SQL text as they are.
+     * The key column is returned as the first column of each row,
+     * followed by `columns`, "*" stands for all the columns of the table.
+     */
+    DbKeysetScanner(DbConnection &connection,
+                    const char *table,
+                    const char *keyColumn,
+                    const char *columns = "*",
+                    unsigned int chunkRows = 10000);
+    ~DbKeysetScanner();
+
+    /** continue the scan with the first row whose key is greater than key */
+    void resumeAfter(int64_t key);
+
+    /** advance to the next row, false at the end of the table */
+    bool next();
+
+    /** the current row, valid until the next call of next */
+    DbRowProxy row();
+
+    /** true once a row was returned or resumeAfter was called */
+    bool hasCheckpoint() const;
+    /** key of the last row returned, resume from here after a failure */
+    int64_t checkpoint() const;
+
+    uint64_t chunkCount() const;
+
+private:
+    DbKeysetScanner(const DbKeysetScanner&) = delete;
+    DbKeysetScanner &operator=(const DbKeysetScanner&) = delete;
+
+    void finishChunk();
+
+    unsigned int chunkRows_;
+    DbTransaction transaction_;
+    /** the first chunk, without a lower key bound */
+    DbStatement first_;
+    /** the following chunks, starting after the checkpoint */
+    DbStatement after_;
+    DbStatement *current_;
+    std::unique_ptr<DbStatement::Iterator> it_;
+    unsigned int rowsInChunk_;
+    uint64_t chunkCount_;
+    bool hasKey_;
+    int64_t lastKey_;
+    bool done_;
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBKEYSETSCANNER_H_ */
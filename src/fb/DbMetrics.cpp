@@ -0,0 +1,313 @@
+/*
+ * DbMetrics.cpp - latency histograms of the library's hot paths
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbMetrics.h"
+
+#include "FbInternals.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+
+namespace fb
+{
+
+namespace {
+
+constexpr int OPERATIONS = static_cast<int>(DbOperation::Count);
+
+/**
+ * log-linear buckets: values below 16ns have a bucket each, above that
+ * every power of two range is split in 16 equal sub-buckets
+ */
+constexpr int SUB_BITS = 4;
+constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+static inline int bucketIndex(uint64_t ns)
+{
+    if (ns < SUB_BUCKETS) {
+        return static_cast<int>(ns);
+    }
+    int msb = 63 - __builtin_clzll(ns);
+    int sub = static_cast<int>((ns >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1));
+    return (msb - SUB_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+/** the largest value falling in bucket idx */
+static inline uint64_t bucketUpperBound(int idx)
+{
+    if (idx < SUB_BUCKETS) {
+        return static_cast<uint64_t>(idx);
+    }
+    int shift = idx / SUB_BUCKETS - 1;
+    uint64_t low = static_cast<uint64_t>(SUB_BUCKETS + idx % SUB_BUCKETS) << shift;
+    return low + ((uint64_t(1) << shift) - 1);
+}
+
+/**
+ * The histograms of one thread. Only the owning thread writes them, so
+ * the counters are updated with plain relaxed loads and stores (no
+ * locked instructions), snapshots read them concurrently.
+ */
+struct Histograms
+{
+    std::atomic<uint64_t> buckets_[OPERATIONS][BUCKETS];
+    std::atomic<uint64_t> sumNs_[OPERATIONS];
+    std::atomic<uint64_t> maxNs_[OPERATIONS];
+
+    Histograms()
+    {
+        for (int op = 0; op != OPERATIONS; ++op) {
+            for (int b = 0; b != BUCKETS; ++b) {
+                buckets_[op][b].store(0, std::memory_order_relaxed);
+            }
+            sumNs_[op].store(0, std::memory_order_relaxed);
+            maxNs_[op].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+static inline void bump(std::atomic<uint64_t> &counter, uint64_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+}
+
+struct Registry
+{
+    std::mutex mutex_;
+    /** histograms of the running threads */
+    std::vector<Histograms*> live_;
+    /** the counts of the threads which exited */
+    Histograms retired_;
+};
+
+/** never destroyed, threads may exit after static destructors ran */
+static Registry &registry()
+{
+    static Registry *r = new Registry;
+    return *r;
+}
+
+/** moves the histograms of an exiting thread into the retired counts */
+struct ThreadSlot
+{
+    Histograms *histograms_;
+
+    ThreadSlot() : histograms_(nullptr)
+    {
+    }
+
+    ~ThreadSlot()
+    {
+        if (!histograms_) {
+            return;
+        }
+
+        Registry &r = registry();
+        std::lock_guard<std::mutex> const lg(r.mutex_);
+        for (int op = 0; op != OPERATIONS; ++op) {
+            for (int b = 0; b != BUCKETS; ++b) {
+                bump(r.retired_.buckets_[op][b],
+                     histograms_->buckets_[op][b].load(std::memory_order_relaxed));
+            }
+            bump(r.retired_.sumNs_[op],
+                 histograms_->sumNs_[op].load(std::memory_order_relaxed));
+            uint64_t mx = histograms_->maxNs_[op].load(std::memory_order_relaxed);
+            if (mx > r.retired_.maxNs_[op].load(std::memory_order_relaxed)) {
+                r.retired_.maxNs_[op].store(mx, std::memory_order_relaxed);
+            }
+        }
+
+        for (auto i = r.live_.begin(); i != r.live_.end(); ++i) {
+            if (*i == histograms_) {
+                r.live_.erase(i);
+                break;
+            }
+        }
+        delete histograms_;
+    }
+};
+
+static thread_local ThreadSlot threadSlot;
+
+static Histograms &threadHistograms()
+{
+    if (!threadSlot.histograms_) {
+        Histograms *h = new Histograms;
+        Registry &r = registry();
+        std::lock_guard<std::mutex> const lg(r.mutex_);
+        r.live_.push_back(h);
+        threadSlot.histograms_ = h;
+    }
+    return *threadSlot.histograms_;
+}
+
+static uint64_t quantile(const std::vector<uint64_t> &buckets,
+                         uint64_t count, uint64_t maxNs, double q)
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count)));
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int b = 0; b != BUCKETS; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            uint64_t v = bucketUpperBound(b);
+            return v < maxNs ? v : maxNs;
+        }
+    }
+    return maxNs;
+}
+
+static const char *const OPERATION_NAMES[OPERATIONS] = {
+    "prepare",
+    "execute",
+    "fetch",
+    "transaction_start",
+    "commit",
+    "rollback",
+    "blob_read",
+    "blob_write",
+};
+
+} /* anonymous namespace */
+
+void recordLatency(DbOperation op, uint64_t ns)
+{
+    Histograms &h = threadHistograms();
+    int i = static_cast<int>(op);
+    bump(h.buckets_[i][bucketIndex(ns)], 1);
+    bump(h.sumNs_[i], ns);
+    if (ns > h.maxNs_[i].load(std::memory_order_relaxed)) {
+        h.maxNs_[i].store(ns, std::memory_order_relaxed);
+    }
+}
+
+const char *operationName(DbOperation op)
+{
+    int i = static_cast<int>(op);
+    if (i < 0 || i >= OPERATIONS) {
+        throw std::out_of_range("not an operation!");
+    }
+    return OPERATION_NAMES[i];
+}
+
+DbMetricsSnapshot::DbMetricsSnapshot()
+{
+    memset(ops_, 0, sizeof(ops_));
+}
+
+DbMetricsSnapshot DbMetricsSnapshot::take()
+{
+    DbMetricsSnapshot snap;
+    std::vector<uint64_t> buckets(BUCKETS);
+
+    Registry &r = registry();
+    std::lock_guard<std::mutex> const lg(r.mutex_);
+
+    for (int op = 0; op != OPERATIONS; ++op) {
+        DbLatencySummary &s = snap.ops_[op];
+        std::fill(buckets.begin(), buckets.end(), 0);
+
+        auto merge = [&](const Histograms &h) {
+            for (int b = 0; b != BUCKETS; ++b) {
+                uint64_t n = h.buckets_[op][b].load(std::memory_order_relaxed);
+                buckets[b] += n;
+                s.count_ += n;
+            }
+            s.sumNs_ += h.sumNs_[op].load(std::memory_order_relaxed);
+            uint64_t mx = h.maxNs_[op].load(std::memory_order_relaxed);
+            if (mx > s.maxNs_) {
+                s.maxNs_ = mx;
+            }
+        };
+
+        merge(r.retired_);
+        for (const Histograms *h : r.live_) {
+            merge(*h);
+        }
+
+        s.p50Ns_ = quantile(buckets, s.count_, s.maxNs_, 0.5);
+        s.p99Ns_ = quantile(buckets, s.count_, s.maxNs_, 0.99);
+        s.p999Ns_ = quantile(buckets, s.count_, s.maxNs_, 0.999);
+    }
+    return snap;
+}
+
+bool DbMetricsSnapshot::enabled()
+{
+#ifdef DBWRAP_FB_METRICS
+    return true;
+#else
+    return false;
+#endif
+}
+
+const DbLatencySummary &DbMetricsSnapshot::operator[](DbOperation op) const
+{
+    int i = static_cast<int>(op);
+    if (i < 0 || i >= OPERATIONS) {
+        throw std::out_of_range("not an operation!");
+    }
+    return ops_[i];
+}
+
+std::string DbMetricsSnapshot::prometheusText(const char *prefix /* = "dbwrap_fb" */) const
+{
+    std::string metric = prefix ? prefix : "dbwrap_fb";
+    metric += "_operation_seconds";
+
+    std::string text;
+    text += "# HELP " + metric + " Latency of DbWrap++FB operations.\n";
+    text += "# TYPE " + metric + " summary\n";
+
+    char line[256];
+    for (int op = 0; op != OPERATIONS; ++op) {
+        const DbLatencySummary &s = ops_[op];
+        const char *name = OPERATION_NAMES[op];
+        const struct { const char *q; uint64_t ns; } quantiles[] = {
+            { "0.5", s.p50Ns_ }, { "0.99", s.p99Ns_ }, { "0.999", s.p999Ns_ }
+        };
+
+        for (const auto &q : quantiles) {
+            snprintf(line, sizeof(line),
+                     "%s{operation=\"%s\",quantile=\"%s\"} %.9f\n",
+                     metric.c_str(), name, q.q, static_cast<double>(q.ns) / 1e9);
+            text += line;
+        }
+        snprintf(line, sizeof(line), "%s_sum{operation=\"%s\"} %.9f\n",
+                 metric.c_str(), name, static_cast<double>(s.sumNs_) / 1e9);
+        text += line;
+        snprintf(line, sizeof(line), "%s_count{operation=\"%s\"} %llu\n",
+                 metric.c_str(), name, static_cast<unsigned long long>(s.count_));
+        text += line;
+    }
+    return text;
+}
+
+} /* namespace fb */
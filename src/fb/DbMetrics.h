@@ -0,0 +1,87 @@
+/*
+ * DbMetrics.h - latency histograms of the library's hot paths
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBMETRICS_H_
+#define DBWRAP_FB_SRC_FB_DBMETRICS_H_
+
+#include <cstdint>
+#include <string>
+
+
+namespace fb
+{
+
+/** the instrumented operations */
+enum class DbOperation
+{
+    Prepare,            ///< DbStatement construction
+    Execute,            ///< DbStatement::execute
+    Fetch,              ///< fetching the next row of a cursor
+    TransactionStart,
+    Commit,             ///< commit and commitRetain
+    Rollback,           ///< rollback and rollbackRetain
+    BlobRead,           ///< one segment read, or a whole readAll
+    BlobWrite,          ///< one segment written
+    Count               ///< number of operations, not an operation
+};
+
+/** name of the operation as used in the Prometheus labels */
+const char *operationName(DbOperation op);
+
+struct DbLatencySummary
+{
+    uint64_t count_;
+    uint64_t sumNs_;
+    uint64_t maxNs_;
+    /** quantiles, within the 1/16 relative precision of the histograms */
+    uint64_t p50Ns_;
+    uint64_t p99Ns_;
+    uint64_t p999Ns_;
+};
+
+/**
+ * Latency of each DbOperation since the program started, merged from
+ * the histograms of all threads when the snapshot is taken.
+ *
+ * The operations are recorded only when the library is built with
+ * DBWRAP_FB_METRICS defined (make METRICS=1), otherwise the timers
+ * compile to nothing and every snapshot is empty.
+ */
+class DbMetricsSnapshot
+{
+public:
+    /** merge the per-thread histograms, recording threads aren't blocked */
+    static DbMetricsSnapshot take();
+
+    /** true if the library records latencies */
+    static bool enabled();
+
+    const DbLatencySummary &operator[](DbOperation op) const;
+
+    /**
+     * render the snapshot in the Prometheus text exposition format,
+     * as one summary metric "<prefix>_operation_seconds" labelled by
+     * operation
+     */
+    std::string prometheusText(const char *prefix = "dbwrap_fb") const;
+
+private:
+    DbMetricsSnapshot();
+
+    DbLatencySummary ops_[static_cast<int>(DbOperation::Count)];
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBMETRICS_H_ */
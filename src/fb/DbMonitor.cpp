@@ -0,0 +1,297 @@
+/*
+ * DbMonitor.cpp - snapshots of the MON$ monitoring tables and their rates
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbMonitor.h"
+
+#include "DbConnection.h"
+#include "FbInternals.h"
+
+#include <cstring>
+#include <string>
+
+
+namespace fb
+{
+
+namespace {
+
+/** the counter columns, in DbMonCounters order */
+static std::string counterColumns()
+{
+    return "io.MON$PAGE_READS, io.MON$PAGE_WRITES, "
+           "io.MON$PAGE_FETCHES, io.MON$PAGE_MARKS, "
+           "r.MON$RECORD_SEQ_READS, r.MON$RECORD_IDX_READS, "
+           "r.MON$RECORD_INSERTS, r.MON$RECORD_UPDATES, "
+           "r.MON$RECORD_DELETES, r.MON$RECORD_BACKOUTS, "
+           "r.MON$RECORD_PURGES, r.MON$RECORD_EXPUNGES";
+}
+
+static std::string statsJoin(const char *alias)
+{
+    std::string a(alias);
+    return " LEFT JOIN MON$IO_STATS io ON io.MON$STAT_ID = " + a + ".MON$STAT_ID"
+           " LEFT JOIN MON$RECORD_STATS r ON r.MON$STAT_ID = " + a + ".MON$STAT_ID";
+}
+
+static std::string ageMs(const char *alias)
+{
+    return std::string("CAST(DATEDIFF(MILLISECOND FROM ") + alias +
+           ".MON$TIMESTAMP TO CURRENT_TIMESTAMP) AS BIGINT), ";
+}
+
+static std::string attachmentsSql()
+{
+    return "SELECT a.MON$ATTACHMENT_ID, a.MON$SERVER_PID, a.MON$STATE, " +
+           ageMs("a") +
+           "a.MON$USER, a.MON$REMOTE_ADDRESS, a.MON$REMOTE_PROCESS, " +
+           counterColumns() + " FROM MON$ATTACHMENTS a" + statsJoin("a") +
+           " ORDER BY a.MON$ATTACHMENT_ID";
+}
+
+static std::string transactionsSql()
+{
+    return "SELECT t.MON$TRANSACTION_ID, t.MON$ATTACHMENT_ID, t.MON$STATE, " +
+           ageMs("t") +
+           "t.MON$TOP_TRANSACTION, t.MON$OLDEST_TRANSACTION, "
+           "t.MON$OLDEST_ACTIVE, t.MON$ISOLATION_MODE, t.MON$READ_ONLY, " +
+           counterColumns() + " FROM MON$TRANSACTIONS t" + statsJoin("t") +
+           " ORDER BY t.MON$TRANSACTION_ID";
+}
+
+static std::string statementsSql()
+{
+    return "SELECT s.MON$STATEMENT_ID, s.MON$ATTACHMENT_ID, "
+           "s.MON$TRANSACTION_ID, s.MON$STATE, " + ageMs("s") +
+           "CAST(SUBSTRING(s.MON$SQL_TEXT FROM 1 FOR 255) AS VARCHAR(255)), " +
+           counterColumns() + " FROM MON$STATEMENTS s" + statsJoin("s") +
+           " ORDER BY s.MON$STATEMENT_ID";
+}
+
+/** an integer column, 0 if null */
+static int64_t intColumn(const XSQLDA *row, int idx)
+{
+    const XSQLVAR &v1 = row->sqlvar[idx];
+    if ((v1.sqltype & 1) && *v1.sqlind == -1) {
+        return 0;
+    }
+
+    switch (v1.sqltype & ~1) {
+    case SQL_SHORT:
+        return *reinterpret_cast<const short*>(v1.sqldata);
+    case SQL_LONG:
+        return *reinterpret_cast<const ISC_LONG*>(v1.sqldata);
+    case SQL_INT64:
+        return *reinterpret_cast<const ISC_INT64*>(v1.sqldata);
+    default:
+        return 0;
+    }
+}
+
+/** copy a text column into a fixed size array, without trailing blanks */
+template <size_t N>
+static void textColumn(const XSQLDA *row, int idx, char (&dst)[N])
+{
+    const XSQLVAR &v1 = row->sqlvar[idx];
+    const char *src = v1.sqldata;
+    size_t length = 0;
+
+    if ((v1.sqltype & 1) && *v1.sqlind == -1) {
+        length = 0;
+    } else if ((v1.sqltype & ~1) == SQL_VARYING) {
+        const FbVarchar *vc = reinterpret_cast<const FbVarchar*>(v1.sqldata);
+        src = vc->str;
+        length = static_cast<size_t>(vc->length);
+    } else if ((v1.sqltype & ~1) == SQL_TEXT) {
+        length = static_cast<size_t>(v1.sqllen);
+    }
+
+    while (length && src[length - 1] == ' ') {
+        --length;
+    }
+    if (length > N - 1) {
+        length = N - 1;
+    }
+    memcpy(dst, src, length);
+    dst[length] = '\0';
+}
+
+static void readCounters(const XSQLDA *row, int first, DbMonCounters &c)
+{
+    int64_t *values[] = {
+        &c.pageReads_, &c.pageWrites_, &c.pageFetches_, &c.pageMarks_,
+        &c.seqReads_, &c.idxReads_, &c.inserts_, &c.updates_,
+        &c.deletes_, &c.backouts_, &c.purges_, &c.expunges_
+    };
+    for (int i = 0; i != static_cast<int>(sizeof(values) / sizeof(values[0])); ++i) {
+        *values[i] = intColumn(row, first + i);
+    }
+}
+
+static void setRate(DbMonRate &rate, const DbMonCounters &before,
+                    const DbMonCounters &after, double seconds)
+{
+    auto perSecond = [seconds](int64_t a, int64_t b) {
+        return a > b ? static_cast<double>(a - b) / seconds : 0.0;
+    };
+    rate.pageReads_ = perSecond(after.pageReads_, before.pageReads_);
+    rate.pageWrites_ = perSecond(after.pageWrites_, before.pageWrites_);
+    rate.pageFetches_ = perSecond(after.pageFetches_, before.pageFetches_);
+    rate.pageMarks_ = perSecond(after.pageMarks_, before.pageMarks_);
+    rate.seqReads_ = perSecond(after.seqReads_, before.seqReads_);
+    rate.idxReads_ = perSecond(after.idxReads_, before.idxReads_);
+    rate.inserts_ = perSecond(after.inserts_, before.inserts_);
+    rate.updates_ = perSecond(after.updates_, before.updates_);
+    rate.deletes_ = perSecond(after.deletes_, before.deletes_);
+}
+
+/** merge two id ordered lists, rating the entries present in both */
+template <typename T, typename AttachmentOf>
+static void diffById(const std::vector<T> &before, const std::vector<T> &after,
+                     double seconds, AttachmentOf attachmentOf,
+                     std::vector<DbMonRate> &rates)
+{
+    rates.clear();
+    auto b = before.begin();
+    for (const T &a : after) {
+        while (b != before.end() && b->id_ < a.id_) {
+            ++b;
+        }
+        if (b == before.end()) {
+            break;
+        }
+        if (b->id_ != a.id_) {
+            continue;
+        }
+
+        DbMonRate rate;
+        rate.id_ = a.id_;
+        rate.attachmentId_ = attachmentOf(a);
+        setRate(rate, b->counters_, a.counters_, seconds);
+        rates.push_back(rate);
+    }
+}
+
+} /* anonymous namespace */
+
+DbMonitor::DbMonitor(DbConnection &connection) :
+        // statements are prepared in a transaction, then reused by the
+        // snapshot transaction of each poll
+        transaction_(connection.nativeHandle(), 1,
+                     DefaultTransMode::Commit,
+                     TransStartMode::StartReadOnly),
+        attachments_(connection.createStatement(attachmentsSql().c_str(),
+                                                &transaction_)),
+        transactions_(connection.createStatement(transactionsSql().c_str(),
+                                                 &transaction_)),
+        statements_(connection.createStatement(statementsSql().c_str(),
+                                               &transaction_))
+{
+    transaction_.commit();
+}
+
+DbMonitor::~DbMonitor()
+{
+}
+
+void DbMonitor::snapshot(DbMonSnapshot &snap)
+{
+    snap.attachments_.clear();
+    snap.transactions_.clear();
+    snap.statements_.clear();
+
+    // the MON$ tables are frozen at their first use in a transaction
+    transaction_.startSnapshot(true);
+    try {
+        snap.takenAt_ = std::chrono::steady_clock::now();
+
+        for (auto it = attachments_.iterate(); it != attachments_.end(); ++it) {
+            const XSQLDA *row = attachments_.results_;
+            DbMonAttachment a;
+            a.id_ = intColumn(row, 0);
+            a.serverPid_ = intColumn(row, 1);
+            a.state_ = static_cast<int>(intColumn(row, 2));
+            a.ageMs_ = intColumn(row, 3);
+            textColumn(row, 4, a.user_);
+            textColumn(row, 5, a.remoteAddress_);
+            textColumn(row, 6, a.remoteProcess_);
+            readCounters(row, 7, a.counters_);
+            snap.attachments_.push_back(a);
+        }
+        attachments_.reset();
+
+        for (auto it = transactions_.iterate(); it != transactions_.end(); ++it) {
+            const XSQLDA *row = transactions_.results_;
+            DbMonTransaction t;
+            t.id_ = intColumn(row, 0);
+            t.attachmentId_ = intColumn(row, 1);
+            t.state_ = static_cast<int>(intColumn(row, 2));
+            t.ageMs_ = intColumn(row, 3);
+            t.topTransaction_ = intColumn(row, 4);
+            t.oldestTransaction_ = intColumn(row, 5);
+            t.oldestActive_ = intColumn(row, 6);
+            t.isolationMode_ = static_cast<int>(intColumn(row, 7));
+            t.readOnly_ = intColumn(row, 8) != 0;
+            readCounters(row, 9, t.counters_);
+            snap.transactions_.push_back(t);
+        }
+        transactions_.reset();
+
+        for (auto it = statements_.iterate(); it != statements_.end(); ++it) {
+            const XSQLDA *row = statements_.results_;
+            DbMonStatement s;
+            s.id_ = intColumn(row, 0);
+            s.attachmentId_ = intColumn(row, 1);
+            s.transactionId_ = intColumn(row, 2);
+            s.state_ = static_cast<int>(intColumn(row, 3));
+            s.ageMs_ = intColumn(row, 4);
+            textColumn(row, 5, s.sql_);
+            readCounters(row, 6, s.counters_);
+            snap.statements_.push_back(s);
+        }
+        statements_.reset();
+
+        transaction_.commit();
+    } catch (...) {
+        try {
+            attachments_.reset();
+            transactions_.reset();
+            statements_.reset();
+            transaction_.rollback();
+        } catch (std::exception &) {
+        }
+        throw;
+    }
+}
+
+void DbMonitor::diff(const DbMonSnapshot &before,
+                     const DbMonSnapshot &after,
+                     DbMonRates &rates)
+{
+    rates.seconds_ = std::chrono::duration<double>(after.takenAt_ -
+                                                   before.takenAt_).count();
+    if (rates.seconds_ <= 0) {
+        rates.attachments_.clear();
+        rates.statements_.clear();
+        return;
+    }
+
+    diffById(before.attachments_, after.attachments_, rates.seconds_,
+             [](const DbMonAttachment &a) { return a.id_; },
+             rates.attachments_);
+    diffById(before.statements_, after.statements_, rates.seconds_,
+             [](const DbMonStatement &s) { return s.attachmentId_; },
+             rates.statements_);
+}
+
+} /* namespace fb */
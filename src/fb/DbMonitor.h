@@ -0,0 +1,167 @@
+/*
+ * DbMonitor.h - snapshots of the MON$ monitoring tables and their rates
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBMONITOR_H_
+#define DBWRAP_FB_SRC_FB_DBMONITOR_H_
+
+#include "DbStatement.h"
+#include "DbTransaction.h"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+
+namespace fb
+{
+
+// forward declarations
+class DbConnection;
+
+/** MON$IO_STATS and MON$RECORD_STATS of an attachment, transaction or statement */
+struct DbMonCounters
+{
+    int64_t pageReads_;
+    int64_t pageWrites_;
+    int64_t pageFetches_;
+    int64_t pageMarks_;
+    int64_t seqReads_;
+    int64_t idxReads_;
+    int64_t inserts_;
+    int64_t updates_;
+    int64_t deletes_;
+    int64_t backouts_;
+    int64_t purges_;
+    int64_t expunges_;
+};
+
+/** text columns are truncated to fit, they're always null terminated */
+struct DbMonAttachment
+{
+    int64_t id_;
+    int64_t serverPid_;
+    /** MON$STATE, 0 idle, 1 active */
+    int state_;
+    /** since the attachment was made */
+    int64_t ageMs_;
+    char user_[64];
+    char remoteAddress_[256];
+    char remoteProcess_[256];
+    DbMonCounters counters_;
+};
+
+struct DbMonTransaction
+{
+    int64_t id_;
+    int64_t attachmentId_;
+    int state_;
+    /** since the transaction started */
+    int64_t ageMs_;
+    int64_t topTransaction_;
+    int64_t oldestTransaction_;
+    int64_t oldestActive_;
+    /** MON$ISOLATION_MODE, 0 consistency, 1 concurrency, 2-4 read committed */
+    int isolationMode_;
+    bool readOnly_;
+    DbMonCounters counters_;
+};
+
+struct DbMonStatement
+{
+    int64_t id_;
+    int64_t attachmentId_;
+    /** 0 if the statement isn't running */
+    int64_t transactionId_;
+    /** MON$STATE, 0 idle, 1 active, 2 stalled */
+    int state_;
+    /** since the statement started running, 0 if it isn't */
+    int64_t ageMs_;
+    /** the start of the SQL text */
+    char sql_[256];
+    DbMonCounters counters_;
+};
+
+/** the monitoring tables as seen by one transaction, ordered by id */
+struct DbMonSnapshot
+{
+    std::chrono::steady_clock::time_point takenAt_;
+    std::vector<DbMonAttachment> attachments_;
+    std::vector<DbMonTransaction> transactions_;
+    std::vector<DbMonStatement> statements_;
+};
+
+/** the counters of an attachment or statement per second */
+struct DbMonRate
+{
+    /** attachment or statement id */
+    int64_t id_;
+    int64_t attachmentId_;
+    double pageReads_;
+    double pageWrites_;
+    double pageFetches_;
+    double pageMarks_;
+    double seqReads_;
+    double idxReads_;
+    double inserts_;
+    double updates_;
+    double deletes_;
+};
+
+/** the rates of the attachments and statements present in both snapshots */
+struct DbMonRates
+{
+    double seconds_;
+    std::vector<DbMonRate> attachments_;
+    std::vector<DbMonRate> statements_;
+};
+
+/**
+ * Reads MON$ATTACHMENTS, MON$TRANSACTIONS and MON$STATEMENTS, each
+ * joined with its MON$IO_STATS and MON$RECORD_STATS, in one snapshot
+ * transaction, so the three tables are consistent with each other.
+ *
+ * The statements are prepared once. Snapshots passed back in reuse
+ * their vectors and the text columns are fixed size arrays, so once the
+ * vectors are large enough a poll allocates only while a
+ * DbTransactionWatchdog records the transactions started or when one of
+ * the statements is reported to the slow query log.
+ */
+class DbMonitor
+{
+public:
+    /** the connection is not owned, it must outlive the monitor */
+    explicit DbMonitor(DbConnection &connection);
+    ~DbMonitor();
+
+    /** replace the contents of snap with the current monitoring data */
+    void snapshot(DbMonSnapshot &snap);
+
+    /** rates from before to after, after being the later snapshot */
+    static void diff(const DbMonSnapshot &before,
+                     const DbMonSnapshot &after,
+                     DbMonRates &rates);
+
+private:
+    DbMonitor(const DbMonitor&) = delete;
+    DbMonitor &operator=(const DbMonitor&) = delete;
+
+    DbTransaction transaction_;
+    DbStatement attachments_;
+    DbStatement transactions_;
+    DbStatement statements_;
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBMONITOR_H_ */
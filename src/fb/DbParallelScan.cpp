@@ -0,0 +1,350 @@
+/*
+ * DbParallelScan.cpp - scan a table by primary key ranges on several
+ *                      connections at once
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbParallelScan.h"
+
+#include "DbConnection.h"
+#include "DbRowProxy.h"
+#include "DbStatement.h"
+#include "DbTransaction.h"
+#include "FbInternals.h"
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+
+namespace fb
+{
+
+struct DbParallelScan::Partition
+{
+    /** inclusive key range */
+    int64_t from_;
+    int64_t to_;
+    /** batches of rows, each row is a copy of the cursor field buffer */
+    std::deque<std::vector<unsigned char>> batches_;
+    bool done_;
+
+    /** the result columns, their data pointers point into row_ */
+    std::unique_ptr<char[]> layout_;
+    std::vector<unsigned char> row_;
+
+    Partition(int64_t from, int64_t to) : from_(from),
+                                          to_(to),
+                                          batches_(),
+                                          done_(false),
+                                          layout_(),
+                                          row_()
+    {
+    }
+
+    SqlDescriptorArea *layout()
+    {
+        return reinterpret_cast<SqlDescriptorArea*>(layout_.get());
+    }
+};
+
+struct DbParallelScan::ScanState
+{
+    std::mutex mutex_;
+    /** signalled when a batch is queued or a partition finished */
+    std::condition_variable produced_;
+    /** signalled when a batch was taken or the scan is stopping */
+    std::condition_variable consumed_;
+    bool stop_;
+    /** the first failure of a partition */
+    std::exception_ptr error_;
+    unsigned int batchRows_;
+    unsigned int maxQueuedBatches_;
+    /** snapshot shared by the partitions, 0 if not supported */
+    int64_t snapshotNumber_;
+
+    ScanState(const DbParallelScanOptions &opts, int64_t snapshotNumber) :
+                        mutex_(),
+                        produced_(),
+                        consumed_(),
+                        stop_(false),
+                        error_(),
+                        batchRows_(std::max(opts.batchRows_, 1u)),
+                        maxQueuedBatches_(std::max(opts.maxQueuedBatches_, 1u)),
+                        snapshotNumber_(snapshotNumber)
+    {
+    }
+};
+
+DbParallelScan::DbParallelScan(DbConnection *const *connections,
+                               unsigned int connCount,
+                               const char *table,
+                               const char *keyColumn,
+                               const char *columns /* = "*" */,
+                               const DbParallelScanOptions &opts
+                                        /* = DbParallelScanOptions() */) :
+                                    connections_(connections,
+                                                 connections + connCount),
+                                    table_(table ? table : ""),
+                                    keyColumn_(keyColumn ? keyColumn : ""),
+                                    columns_(columns ? columns : ""),
+                                    opts_(opts)
+{
+    if (connCount == 0) {
+        throw std::invalid_argument("A parallel scan needs at least one connection!");
+    }
+
+    if (table_.empty() || keyColumn_.empty() || columns_.empty()) {
+        throw std::invalid_argument("invalid parallel scan arguments!");
+    }
+}
+
+uint64_t DbParallelScan::run(const RowCallback &onRow)
+{
+    // the partitions share the snapshot of this transaction, it must
+    // stay active until they all started
+    DbTransaction source(connections_[0]->nativeHandle(), 1,
+                         DefaultTransMode::Commit,
+                         TransStartMode::DeferStart);
+    int64_t snapshotNumber = opts_.snapshotNumber_;
+    if (snapshotNumber != 0) {
+        source.startAtSnapshot(snapshotNumber);
+    } else {
+        source.startSnapshot();
+        try {
+            snapshotNumber = source.snapshotNumber();
+        } catch (std::exception &) {
+            // the client library or the server can't share snapshots
+            snapshotNumber = 0;
+        }
+    }
+
+    int64_t lowKey;
+    int64_t highKey;
+    {
+        std::string sql = "SELECT MIN(" + keyColumn_ + "), MAX(" +
+                          keyColumn_ + ") FROM " + table_;
+        DbStatement st = connections_[0]->createStatement(sql.c_str(), &source);
+        DbRowProxy range = st.uniqueResult();
+        if (range.fieldIsNull(0)) {
+            // the table is empty
+            return 0;
+        }
+        lowKey = range.getInt64(0);
+        highKey = range.getInt64(1);
+    }
+
+    // split the key range in equal parts, unsigned arithmetic
+    // doesn't overflow for any int64_t range
+    const uint64_t width = static_cast<uint64_t>(highKey) -
+                           static_cast<uint64_t>(lowKey);
+    const uint64_t count = connections_.size();
+    const uint64_t step = width / count + 1;
+
+    std::vector<std::unique_ptr<Partition>> partitions;
+    std::vector<DbConnection*> partitionConnections;
+    for (uint64_t p = 0; p != count; ++p) {
+        const uint64_t first = p * step;
+        if (first > width) {
+            break;
+        }
+        const uint64_t last = std::min(first + (step - 1), width);
+        partitions.emplace_back(new Partition(
+                static_cast<int64_t>(static_cast<uint64_t>(lowKey) + first),
+                static_cast<int64_t>(static_cast<uint64_t>(lowKey) + last)));
+        partitionConnections.push_back(connections_[p]);
+    }
+
+    // "SELECT key, * FROM t" isn't valid SQL, the star must be qualified
+    std::string sql = "SELECT " + keyColumn_ + ", " +
+                      (columns_ == "*" ? table_ + ".*" : columns_) +
+                      " FROM " + table_ +
+                      " WHERE " + keyColumn_ + " BETWEEN ? AND ?";
+    if (opts_.ordered_) {
+        sql += " ORDER BY " + keyColumn_;
+    }
+
+    ScanState state(opts_, snapshotNumber);
+    std::vector<std::thread> threads;
+    uint64_t delivered = 0;
+
+    try {
+        for (size_t p = 0; p != partitions.size(); ++p) {
+            threads.emplace_back(&DbParallelScan::scanPartition,
+                                 partitionConnections[p], sql,
+                                 partitions[p].get(), &state);
+        }
+
+        std::unique_lock<std::mutex> lk(state.mutex_);
+        size_t current = 0;
+        while (!state.stop_) {
+            Partition *from = nullptr;
+            if (opts_.ordered_) {
+                // partitions are consumed one after another, in key order
+                while (current != partitions.size() &&
+                       partitions[current]->done_ &&
+                       partitions[current]->batches_.empty()) {
+                    ++current;
+                }
+                if (current == partitions.size()) {
+                    break;
+                }
+                if (!partitions[current]->batches_.empty()) {
+                    from = partitions[current].get();
+                }
+            } else {
+                // take turns so that no partition gets stalled
+                bool allDone = true;
+                for (size_t i = 0; i != partitions.size(); ++i) {
+                    Partition *p = partitions[(current + i) % partitions.size()].get();
+                    if (!p->batches_.empty()) {
+                        from = p;
+                        current = (current + i + 1) % partitions.size();
+                        break;
+                    }
+                    allDone = allDone && p->done_;
+                }
+                if (!from && allDone) {
+                    break;
+                }
+            }
+
+            if (!from) {
+                state.produced_.wait(lk);
+                continue;
+            }
+
+            std::vector<unsigned char> batch = std::move(from->batches_.front());
+            from->batches_.pop_front();
+            lk.unlock();
+            state.consumed_.notify_all();
+
+            const size_t rowSize = from->row_.size();
+            for (size_t offset = 0; offset < batch.size(); offset += rowSize) {
+                memcpy(from->row_.data(), batch.data() + offset, rowSize);
+                // the partition transactions may be gone, so no blobs
+                const DbRowProxy row(from->layout(), 0, 0);
+                onRow(row);
+                ++delivered;
+            }
+
+            lk.lock();
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> const lg(state.mutex_);
+            state.stop_ = true;
+        }
+        state.consumed_.notify_all();
+        for (auto &t : threads) {
+            t.join();
+        }
+        throw;
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    if (state.error_) {
+        std::rethrow_exception(state.error_);
+    }
+    return delivered;
+}
+
+void DbParallelScan::scanPartition(DbConnection *connection,
+                                   const std::string &sql,
+                                   Partition *partition,
+                                   ScanState *state)
+{
+    try {
+        DbTransaction tr(connection->nativeHandle(), 1,
+                         DefaultTransMode::Commit,
+                         TransStartMode::DeferStart);
+        if (state->snapshotNumber_ != 0) {
+            tr.startAtSnapshot(state->snapshotNumber_);
+        } else {
+            tr.startSnapshot();
+        }
+        DbStatement st = connection->createStatement(sql.c_str(), &tr);
+        st.setInt(1, partition->from_);
+        st.setInt(2, partition->to_);
+
+        // the consumer reads the rows through a copy of the result
+        // columns pointing into the partition row buffer
+        const size_t rowSize = xsqldaFieldsSize(st.results_, st.fields_);
+        partition->layout_.reset(reinterpret_cast<char*>(cloneXsqlda(st.results_)));
+        partition->row_.resize(rowSize);
+        rebaseXsqldaFields(partition->layout(), st.fields_, partition->row_.data());
+
+        const size_t batchSize = rowSize * state->batchRows_;
+        std::vector<unsigned char> batch;
+        batch.reserve(batchSize);
+
+        for (auto it = st.iterate(); it != st.end(); ++it) {
+            batch.insert(batch.end(), st.fields_, st.fields_ + rowSize);
+            if (batch.size() >= batchSize) {
+                if (!pushBatch(state, partition, batch)) {
+                    break;
+                }
+                batch.clear();
+                batch.reserve(batchSize);
+            }
+        }
+
+        if (!batch.empty()) {
+            pushBatch(state, partition, batch);
+        }
+        st.reset();
+    } catch (...) {
+        std::lock_guard<std::mutex> const lg(state->mutex_);
+        if (!state->error_) {
+            state->error_ = std::current_exception();
+        }
+        state->stop_ = true;
+    }
+
+    {
+        std::lock_guard<std::mutex> const lg(state->mutex_);
+        partition->done_ = true;
+    }
+    state->produced_.notify_all();
+    state->consumed_.notify_all();
+}
+
+bool DbParallelScan::pushBatch(ScanState *state, Partition *partition,
+                               std::vector<unsigned char> &batch)
+{
+    {
+        std::unique_lock<std::mutex> lk(state->mutex_);
+        state->consumed_.wait(lk, [state, partition] {
+            return state->stop_ ||
+                   partition->batches_.size() < state->maxQueuedBatches_;
+        });
+
+        if (state->stop_) {
+            return false;
+        }
+        partition->batches_.push_back(std::move(batch));
+    }
+    state->produced_.notify_all();
+    return true;
+}
+
+} /* namespace fb */
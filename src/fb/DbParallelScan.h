@@ -0,0 +1,120 @@
+/*
+ * DbParallelScan.h - scan a table by primary key ranges on several
+ *                    connections at once
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBPARALLELSCAN_H_
+#define DBWRAP_FB_SRC_FB_DBPARALLELSCAN_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+namespace fb
+{
+
+// forward declarations
+class DbConnection;
+class DbRowProxy;
+
+struct DbParallelScanOptions
+{
+    /** deliver the rows in key order, else in the order they arrive */
+    bool ordered_;
+    /** rows a partition hands over to the consumer at a time */
+    unsigned int batchRows_;
+    /** a partition waits while this many of its batches are not consumed */
+    unsigned int maxQueuedBatches_;
+    /**
+     * read the snapshot of a running transaction (see
+     * DbTransaction::snapshotNumber), e.g. to scan several tables at
+     * one consistent state, 0 to start a new snapshot
+     */
+    int64_t snapshotNumber_;
+
+    explicit DbParallelScanOptions(bool ordered = false,
+                                   unsigned int batchRows = 256,
+                                   unsigned int maxQueuedBatches = 16,
+                                   int64_t snapshotNumber = 0)
+              : ordered_(ordered),
+                batchRows_(batchRows),
+                maxQueuedBatches_(maxQueuedBatches),
+                snapshotNumber_(snapshotNumber)
+    {
+    }
+};
+
+/**
+ * Splits the integer key range of a table into one partition per
+ * connection and reads the partitions concurrently, one thread and one
+ * cursor each. The rows of all partitions are merged into a single
+ * stream handed to a callback on the thread calling run().
+ *
+ * All partitions read the same snapshot of the database when the client
+ * and the server support shared snapshots (Firebird 4), otherwise each
+ * partition reads its own snapshot taken when the scan starts.
+ *
+ * As with DbKeysetScanner, the key column is the first column of each
+ * row, followed by the columns asked for ("*" for all the columns).
+ * Rows are copied out of the partition cursors, so blob columns can't
+ * be opened from the callback.
+ */
+class DbParallelScan
+{
+public:
+    typedef std::function<void (const DbRowProxy &row)> RowCallback;
+
+    /**
+     * the connections are not owned, they must not be used by other
+     * threads while run() is executing
+     */
+    DbParallelScan(DbConnection *const *connections,
+                   unsigned int connCount,
+                   const char *table,
+                   const char *keyColumn,
+                   const char *columns = "*",
+                   const DbParallelScanOptions &opts = DbParallelScanOptions());
+
+    /**
+     * scan the table, if a partition fails or the callback throws the
+     * scan is stopped and the exception is rethrown
+     * \return the number of rows delivered
+     */
+    uint64_t run(const RowCallback &onRow);
+
+private:
+    DbParallelScan(const DbParallelScan&) = delete;
+    DbParallelScan &operator=(const DbParallelScan&) = delete;
+
+    struct Partition;
+    struct ScanState;
+
+    /** the body of a partition thread */
+    static void scanPartition(DbConnection *connection, const std::string &sql,
+                              Partition *partition, ScanState *state);
+    /** hand a batch over to the consumer, false if the scan is stopping */
+    static bool pushBatch(ScanState *state, Partition *partition,
+                          std::vector<unsigned char> &batch);
+
+    std::vector<DbConnection*> connections_;
+    std::string table_;
+    std::string keyColumn_;
+    std::string columns_;
+    DbParallelScanOptions opts_;
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBPARALLELSCAN_H_ */
@@ -0,0 +1,81 @@
+/*
+ * DbParam.cpp - a statement parameter value that can be stored and
+ *               bound later
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbParam.h"
+
+#include "DbStatement.h"
+
+#include <utility>
+
+
+namespace fb
+{
+
+DbParam::DbParam() : type_(Type::Null), int_(0), text_()
+{
+}
+
+DbParam::DbParam(std::nullptr_t) : type_(Type::Null), int_(0), text_()
+{
+}
+
+DbParam::DbParam(const char *v) : type_(v ? Type::Text : Type::Null),
+                                  int_(0),
+                                  text_(v ? v : "")
+{
+}
+
+DbParam::DbParam(std::string v) : type_(Type::Text),
+                                  int_(0),
+                                  text_(std::move(v))
+{
+}
+
+DbParam::Type DbParam::type() const
+{
+    return type_;
+}
+
+bool DbParam::isNull() const
+{
+    return type_ == Type::Null;
+}
+
+int64_t DbParam::intValue() const
+{
+    return int_;
+}
+
+const std::string &DbParam::textValue() const
+{
+    return text_;
+}
+
+void DbParam::bind(DbStatement &st, unsigned int idx) const
+{
+    switch (type_) {
+    case Type::Null:
+        st.setNull(idx);
+        break;
+    case Type::Int:
+        st.setInt(idx, int_);
+        break;
+    case Type::Text:
+        st.setText(idx, text_.data(), static_cast<int>(text_.size()));
+        break;
+    }
+}
+
+} /* namespace fb */
@@ -0,0 +1,71 @@
+/*
+ * DbParam.h - a statement parameter value that can be stored and
+ *             bound later
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBPARAM_H_
+#define DBWRAP_FB_SRC_FB_DBPARAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+
+namespace fb
+{
+
+// forward declarations
+class DbStatement;
+
+class DbParam
+{
+public:
+    enum class Type
+    {
+        Null = 0,
+        Int,
+        Text
+    };
+
+    /** a null value */
+    DbParam();
+    DbParam(std::nullptr_t);
+
+    template <typename T, typename = typename std::enable_if<
+                                        std::is_integral<T>::value>::type>
+    DbParam(T v) : type_(Type::Int), int_(static_cast<int64_t>(v)), text_()
+    {
+    }
+
+    /** a null pointer is stored as a null value */
+    DbParam(const char *v);
+    DbParam(std::string v);
+
+    Type type() const;
+    bool isNull() const;
+    int64_t intValue() const;
+    const std::string &textValue() const;
+
+    /** bind the value to the 1 based parameter idx of st */
+    void bind(DbStatement &st, unsigned int idx) const;
+
+private:
+    Type type_;
+    int64_t int_;
+    std::string text_;
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBPARAM_H_ */
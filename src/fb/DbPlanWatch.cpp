@@ -0,0 +1,132 @@
+/*
+ * DbPlanWatch.cpp - detect access plan changes of prepared statements
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbPlanWatch.h"
+
+#include "DbQueryStats.h"
+#include "FbInternals.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+
+namespace fb
+{
+
+constexpr size_t DbPlanWatch::MAX_PLANS;
+
+namespace {
+
+struct PlanWatchState
+{
+    std::atomic<bool> enabled_;
+    std::atomic<uint64_t> changes_;
+    std::mutex mutex_;
+    std::shared_ptr<const DbPlanChangeCallback> callback_;
+    /** the last plan by query digest */
+    std::unordered_map<std::string, std::string> plans_;
+
+    PlanWatchState() : enabled_(false), changes_(0)
+    {
+    }
+};
+
+/** never destroyed, statements may be prepared after static destructors ran */
+static PlanWatchState &state()
+{
+    static PlanWatchState *s = new PlanWatchState;
+    return *s;
+}
+
+} /* anonymous namespace */
+
+void DbPlanWatch::enable(DbPlanChangeCallback callback /* = nullptr */)
+{
+    PlanWatchState &s = state();
+    std::lock_guard<std::mutex> const lg(s.mutex_);
+    if (callback) {
+        s.callback_ = std::make_shared<const DbPlanChangeCallback>(std::move(callback));
+    } else {
+        s.callback_.reset();
+    }
+    s.enabled_.store(true, std::memory_order_relaxed);
+}
+
+void DbPlanWatch::disable()
+{
+    PlanWatchState &s = state();
+    std::lock_guard<std::mutex> const lg(s.mutex_);
+    s.enabled_.store(false, std::memory_order_relaxed);
+    s.callback_.reset();
+    s.plans_.clear();
+}
+
+uint64_t DbPlanWatch::changeCount()
+{
+    return state().changes_.load(std::memory_order_relaxed);
+}
+
+bool planWatchEnabled()
+{
+    return state().enabled_.load(std::memory_order_relaxed);
+}
+
+void checkStatementPlan(const char *sql, FbApiHandle statement)
+{
+    DbPlanChange change;
+    try {
+        change.plan_ = statementPlan(statement);
+    } catch (std::exception &) {
+        // no plan, nothing to compare
+        return;
+    }
+    if (change.plan_.empty()) {
+        // statements without a plan, like EXECUTE PROCEDURE
+        return;
+    }
+    change.digest_ = DbQueryStats::normalize(sql);
+
+    PlanWatchState &s = state();
+    std::shared_ptr<const DbPlanChangeCallback> callback;
+    {
+        std::lock_guard<std::mutex> const lg(s.mutex_);
+        auto i = s.plans_.find(change.digest_);
+        if (i == s.plans_.end()) {
+            if (s.plans_.size() < DbPlanWatch::MAX_PLANS) {
+                s.plans_.emplace(change.digest_, change.plan_);
+            }
+            return;
+        }
+        if (i->second == change.plan_) {
+            return;
+        }
+
+        change.previousPlan_ = i->second;
+        i->second = change.plan_;
+        s.changes_.fetch_add(1, std::memory_order_relaxed);
+        callback = s.callback_;
+    }
+
+    if (callback) {
+        try {
+            (*callback)(change);
+        } catch (...) {
+            // a failing callback mustn't fail preparing the statement
+        }
+    }
+}
+
+} /* namespace fb */
@@ -0,0 +1,69 @@
+/*
+ * DbPlanWatch.h - detect access plan changes of prepared statements
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBPLANWATCH_H_
+#define DBWRAP_FB_SRC_FB_DBPLANWATCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+
+namespace fb
+{
+
+/** a statement was prepared with a plan different from the last one */
+struct DbPlanChange
+{
+    /** the query digest, see DbQueryStats::normalize */
+    std::string digest_;
+    std::string previousPlan_;
+    std::string plan_;
+};
+
+typedef std::function<void(const DbPlanChange&)> DbPlanChangeCallback;
+
+/**
+ * While enabled, the plan of every statement prepared by DbStatement is
+ * read and remembered by query digest. When a statement with the same
+ * digest is prepared with another plan, e.g. after the index statistics
+ * changed, the change is counted and passed to the callback, on the
+ * thread preparing the statement.
+ *
+ * The plans are kept by digest only, statements with the same text
+ * prepared on databases with different indexes are reported as changes.
+ * At most MAX_PLANS digests are remembered.
+ */
+class DbPlanWatch
+{
+public:
+    /**
+     * start watching, the callback may be null if counting the changes
+     * is enough, it may be called by several threads at once
+     */
+    static void enable(DbPlanChangeCallback callback = nullptr);
+
+    /** stop watching and forget the remembered plans */
+    static void disable();
+
+    /** plan changes seen since the program started */
+    static uint64_t changeCount();
+
+    static constexpr size_t MAX_PLANS = 5000;
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBPLANWATCH_H_ */
@@ -0,0 +1,60 @@
+/*
+ * DbProbes.h - private header, USDT (user level static) tracepoints
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBPROBES_H_
+#define DBWRAP_FB_SRC_FB_DBPROBES_H_
+
+/*
+ * Built with DBWRAP_FB_USDT (make USDT=1) the library has static
+ * tracepoints of the "dbwrap_fb" provider, a single nop each until a
+ * tracer attaches, e.g.
+ *   bpftrace -e 'usdt:build/libDbWrap++FB.so:dbwrap_fb:prepare__start
+ *                { printf("%s\n", str(arg0)); }'
+ * Without it they compile to nothing.
+ *
+ *  probe                  arguments
+ *  prepare__start         const char *sql
+ *  prepare__done          const char *sql, statement handle, int failed
+ *  execute__start         statement handle
+ *  execute__done          statement handle, long status
+ *  fetch__start           statement handle
+ *  fetch__done            statement handle, long status (100 at the end)
+ *  begin__start           DbTransaction * (a transaction start)
+ *  begin__done            DbTransaction *, int failed
+ *  commit__start          DbTransaction *
+ *  commit__done           DbTransaction *, int failed
+ *  blob__read             blob handle, unsigned bytes read, long status
+ *  blob__write            blob handle, unsigned bytes, long status
+ *  exception              long sql code, const char *message
+ *
+ * The start and done pairs run on the same thread, statement handles
+ * are the isc_stmt_handle values.
+ */
+#ifdef DBWRAP_FB_USDT
+
+#include <sys/sdt.h>
+
+#define DBWRAP_PROBE1(name, a) DTRACE_PROBE1(dbwrap_fb, name, a)
+#define DBWRAP_PROBE2(name, a, b) DTRACE_PROBE2(dbwrap_fb, name, a, b)
+#define DBWRAP_PROBE3(name, a, b, c) DTRACE_PROBE3(dbwrap_fb, name, a, b, c)
+
+#else
+
+#define DBWRAP_PROBE1(name, a) ((void) 0)
+#define DBWRAP_PROBE2(name, a, b) ((void) 0)
+#define DBWRAP_PROBE3(name, a, b, c) ((void) 0)
+
+#endif
+
+#endif /* DBWRAP_FB_SRC_FB_DBPROBES_H_ */
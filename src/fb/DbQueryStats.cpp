@@ -0,0 +1,382 @@
+/*
+ * DbQueryStats.cpp - client side statistics aggregated per query digest
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbQueryStats.h"
+
+#include "FbInternals.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+
+namespace fb
+{
+
+constexpr size_t DbQueryStats::MAX_DIGESTS;
+const char DbQueryStats::OVERFLOW_DIGEST[] = "<other>";
+
+struct QueryDigest
+{
+    std::string digest_;
+    std::atomic<uint64_t> calls_;
+    std::atomic<uint64_t> errors_;
+    std::atomic<uint64_t> rows_;
+    std::atomic<uint64_t> totalNs_;
+    std::atomic<uint64_t> minNs_;
+    std::atomic<uint64_t> maxNs_;
+
+    explicit QueryDigest(const std::string &digest) : digest_(digest),
+                                                      calls_(0),
+                                                      errors_(0),
+                                                      rows_(0),
+                                                      totalNs_(0),
+                                                      minNs_(std::numeric_limits<uint64_t>::max()),
+                                                      maxNs_(0)
+    {
+    }
+};
+
+namespace {
+
+/** the digests are spread over shards, each with its own lock */
+constexpr size_t SHARDS = 16;
+
+struct Shard
+{
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<QueryDigest>> digests_;
+};
+
+struct Registry
+{
+    Shard shards_[SHARDS];
+    std::atomic<size_t> size_;
+
+    Registry() : size_(0)
+    {
+    }
+};
+
+/**
+ * never destroyed, statements may record their last call after static
+ * destructors ran, the digests are never removed for the same reason
+ */
+static Registry &registry()
+{
+    static Registry *r = new Registry;
+    return *r;
+}
+
+#ifdef DBWRAP_FB_METRICS
+static QueryDigest *findDigest(const std::string &digest)
+{
+    Registry &r = registry();
+    Shard &shard = r.shards_[std::hash<std::string>()(digest) % SHARDS];
+
+    std::lock_guard<std::mutex> const lg(shard.mutex_);
+    auto i = shard.digests_.find(digest);
+    if (i != shard.digests_.end()) {
+        return i->second.get();
+    }
+
+    if (r.size_.load(std::memory_order_relaxed) >= DbQueryStats::MAX_DIGESTS &&
+        digest != DbQueryStats::OVERFLOW_DIGEST) {
+        return nullptr;
+    }
+
+    r.size_.fetch_add(1, std::memory_order_relaxed);
+    QueryDigest *d = new QueryDigest(digest);
+    shard.digests_.emplace(digest, std::unique_ptr<QueryDigest>(d));
+    return d;
+}
+#endif
+
+static inline bool isWordChar(char c)
+{
+    return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+static inline bool isDigit(char c)
+{
+    return isdigit(static_cast<unsigned char>(c)) != 0;
+}
+
+/** how a character of a digest is spaced from its neighbours */
+enum class TokenKind
+{
+    None,
+    /** identifiers, keywords and literals */
+    Word,
+    Open,
+    Close,
+    /** ',' and ';', no space before them */
+    Comma,
+    /** no space around it */
+    Dot,
+    Operator
+};
+
+static TokenKind tokenKind(char c)
+{
+    if (isWordChar(c) || c == '\'' || c == '"' || c == '?' || c == ':' ||
+        static_cast<unsigned char>(c) >= 0x80) {
+        return TokenKind::Word;
+    }
+
+    switch (c) {
+    case '(':
+    case '[':
+        return TokenKind::Open;
+    case ')':
+    case ']':
+        return TokenKind::Close;
+    case ',':
+    case ';':
+        return TokenKind::Comma;
+    case '.':
+        return TokenKind::Dot;
+    default:
+        return TokenKind::Operator;
+    }
+}
+
+static bool isTwoCharOperator(char a, char b)
+{
+    static const char *const OPERATORS[] = {
+        "<=", ">=", "<>", "!=", "^=", "~=", "||"
+    };
+    for (const char *op : OPERATORS) {
+        if (op[0] == a && op[1] == b) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} /* anonymous namespace */
+
+std::string DbQueryStats::normalize(const char *sql)
+{
+    std::string digest;
+    if (!sql) {
+        return digest;
+    }
+
+    TokenKind prev = TokenKind::None;
+    bool space = false;
+    for (const char *p = sql; *p; ) {
+        const char *next = skipLiteralOrComment(p);
+        char c = *p;
+
+        if (next == p && isspace(static_cast<unsigned char>(c))) {
+            space = true;
+            ++p;
+            continue;
+        }
+
+        if (next != p && c != '\'' && c != '"') {
+            // a comment separates words like white space
+            space = true;
+            p = next;
+            continue;
+        }
+
+        const TokenKind kind = tokenKind(c);
+        if (prev == kind && !space &&
+            (kind == TokenKind::Word ||
+             (kind == TokenKind::Operator && isTwoCharOperator(digest.back(), c)))) {
+            // the same word or operator goes on
+        } else if (kind != TokenKind::Comma && kind != TokenKind::Close &&
+                   kind != TokenKind::Dot && prev != TokenKind::Open &&
+                   prev != TokenKind::Dot && prev != TokenKind::None) {
+            // the spacing of the text doesn't matter, "IN (1,2)" and
+            // "IN ( 1, 2 )" have the same digest
+            digest += ' ';
+        }
+        prev = kind;
+        const bool spaceBefore = space;
+        space = false;
+
+        if (c == '\'') {
+            digest += '?';
+            p = next;
+        } else if (c == '"') {
+            // quoted identifiers are case sensitive
+            digest.append(p, static_cast<size_t>(next - p));
+            p = next;
+        } else if (isDigit(c) || (c == '.' && isDigit(p[1]))) {
+            // a number (123, 1.5, .5, 1e-3), unless it ends an identifier
+            if (!spaceBefore && !digest.empty() && isWordChar(digest.back())) {
+                digest += c;
+                ++p;
+                continue;
+            }
+            while (isDigit(*p) || *p == '.') {
+                ++p;
+            }
+            if ((*p == 'e' || *p == 'E') &&
+                (isDigit(p[1]) || ((p[1] == '-' || p[1] == '+') && isDigit(p[2])))) {
+                p += 2;
+                while (isDigit(*p)) {
+                    ++p;
+                }
+            }
+            digest += '?';
+        } else {
+            digest += static_cast<char>(toupper(static_cast<unsigned char>(c)));
+            ++p;
+        }
+    }
+    return digest;
+}
+
+std::vector<DbQueryDigestStats> DbQueryStats::top(size_t n)
+{
+    std::vector<DbQueryDigestStats> result;
+
+    Registry &r = registry();
+    for (Shard &shard : r.shards_) {
+        std::lock_guard<std::mutex> const lg(shard.mutex_);
+        for (const auto &i : shard.digests_) {
+            const QueryDigest &d = *i.second;
+            DbQueryDigestStats s;
+            s.calls_ = d.calls_.load(std::memory_order_relaxed);
+            if (s.calls_ == 0) {
+                continue;
+            }
+            s.digest_ = d.digest_;
+            s.errors_ = d.errors_.load(std::memory_order_relaxed);
+            s.rows_ = d.rows_.load(std::memory_order_relaxed);
+            s.totalNs_ = d.totalNs_.load(std::memory_order_relaxed);
+            s.minNs_ = d.minNs_.load(std::memory_order_relaxed);
+            s.maxNs_ = d.maxNs_.load(std::memory_order_relaxed);
+            if (s.minNs_ > s.maxNs_) {
+                // a reset raced with the call
+                s.minNs_ = s.maxNs_;
+            }
+            result.push_back(std::move(s));
+        }
+    }
+
+    auto byTotal = [](const DbQueryDigestStats &a, const DbQueryDigestStats &b) {
+        return a.totalNs_ > b.totalNs_;
+    };
+    if (result.size() > n) {
+        std::partial_sort(result.begin(), result.begin() + n, result.end(), byTotal);
+        result.resize(n);
+    } else {
+        std::sort(result.begin(), result.end(), byTotal);
+    }
+    return result;
+}
+
+void DbQueryStats::reset()
+{
+    Registry &r = registry();
+    for (Shard &shard : r.shards_) {
+        std::lock_guard<std::mutex> const lg(shard.mutex_);
+        for (auto &i : shard.digests_) {
+            QueryDigest &d = *i.second;
+            d.calls_.store(0, std::memory_order_relaxed);
+            d.errors_.store(0, std::memory_order_relaxed);
+            d.rows_.store(0, std::memory_order_relaxed);
+            d.totalNs_.store(0, std::memory_order_relaxed);
+            d.minNs_.store(std::numeric_limits<uint64_t>::max(),
+                           std::memory_order_relaxed);
+            d.maxNs_.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+#ifdef DBWRAP_FB_METRICS
+QueryDigestCall *newQueryDigestCall(const char *sql)
+{
+    QueryDigest *digest = findDigest(DbQueryStats::normalize(sql));
+    if (!digest) {
+        digest = findDigest(DbQueryStats::OVERFLOW_DIGEST);
+    }
+    return new QueryDigestCall(digest, sql);
+}
+#endif
+
+QueryDigestCall::QueryDigestCall(QueryDigest *digest, const char *sql) :
+                                    digest_(digest),
+                                    sql_(sql ? sql : ""),
+                                    statement_(0),
+                                    params_(nullptr),
+                                    executeNs_(0),
+                                    fetchNs_(0),
+                                    rows_(0),
+                                    open_(false)
+{
+}
+
+QueryDigestCall::~QueryDigestCall()
+{
+    finish();
+}
+
+void QueryDigestCall::begin(FbApiHandle statement, const XSQLDA *params)
+{
+    finish();
+    statement_ = statement;
+    params_ = params;
+    executeNs_ = 0;
+    fetchNs_ = 0;
+    rows_ = 0;
+    open_ = true;
+}
+
+void QueryDigestCall::finish(bool failed /* = false */)
+{
+    if (!open_) {
+        return;
+    }
+    open_ = false;
+
+    const uint64_t ns = executeNs_ + fetchNs_;
+    const uint64_t threshold = slowQueryThresholdNs();
+    if (threshold != 0 && ns >= threshold) {
+        reportSlowQuery(sql_, statement_, params_, executeNs_, fetchNs_,
+                        rows_, failed);
+    }
+
+    if (!digest_) {
+        return;
+    }
+
+    QueryDigest &d = *digest_;
+    d.calls_.fetch_add(1, std::memory_order_relaxed);
+    if (failed) {
+        d.errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+    d.rows_.fetch_add(rows_, std::memory_order_relaxed);
+    d.totalNs_.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t v = d.minNs_.load(std::memory_order_relaxed);
+    while (ns < v &&
+           !d.minNs_.compare_exchange_weak(v, ns, std::memory_order_relaxed)) {
+    }
+    v = d.maxNs_.load(std::memory_order_relaxed);
+    while (ns > v &&
+           !d.maxNs_.compare_exchange_weak(v, ns, std::memory_order_relaxed)) {
+    }
+}
+
+} /* namespace fb */
@@ -0,0 +1,77 @@
+/*
+ * DbQueryStats.h - client side statistics aggregated per query digest
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBQUERYSTATS_H_
+#define DBWRAP_FB_SRC_FB_DBQUERYSTATS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace fb
+{
+
+/** the statistics of one query digest */
+struct DbQueryDigestStats
+{
+    /** the normalised SQL text */
+    std::string digest_;
+    uint64_t calls_;
+    /** calls which failed */
+    uint64_t errors_;
+    /** rows fetched by all calls */
+    uint64_t rows_;
+    /**
+     * latency of the calls, a call of a SELECT lasts from execute
+     * until the last row is fetched or the cursor is closed
+     */
+    uint64_t totalNs_;
+    uint64_t minNs_;
+    uint64_t maxNs_;
+};
+
+/**
+ * Statistics of the statements run through DbStatement and
+ * DbConnection::executeUpdate, aggregated by query digest: the SQL text
+ * with its string and number literals replaced by '?', comments removed,
+ * unquoted words in upper case and tokens spaced the same way whatever
+ * the spacing of the text, e.g. "IN (?, ?)". A statement's
+ * digest is computed once, when it's prepared.
+ *
+ * The statistics are recorded only when the library is built with
+ * DBWRAP_FB_METRICS defined (make METRICS=1). At most MAX_DIGESTS
+ * digests are kept, the calls of any further ones are added to the
+ * OVERFLOW_DIGEST entry.
+ */
+class DbQueryStats
+{
+public:
+    /** the digest of sql */
+    static std::string normalize(const char *sql);
+
+    /** the n digests with the highest total latency, highest first */
+    static std::vector<DbQueryDigestStats> top(size_t n);
+
+    /** zero the statistics of all digests */
+    static void reset();
+
+    static constexpr size_t MAX_DIGESTS = 5000;
+    static const char OVERFLOW_DIGEST[];
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBQUERYSTATS_H_ */
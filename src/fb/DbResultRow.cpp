@@ -0,0 +1,78 @@
+/*
+ * DbResultRow.cpp - a single result row that owns its field buffers
+ *
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbResultRow.h"
+
+#include "FbInternals.h"
+
+
+namespace fb
+{
+
+DbResultRow::DbResultRow(SqlDescriptorArea *sqlda,
+                         unsigned char *fields,
+                         bool hasRow) : sqlda_(sqlda),
+                                        fields_(fields),
+                                        hasRow_(hasRow)
+{
+}
+
+DbResultRow::DbResultRow(DbResultRow &&r) : sqlda_(r.sqlda_),
+                                            fields_(r.fields_),
+                                            hasRow_(r.hasRow_)
+{
+    r.sqlda_ = nullptr;
+    r.fields_ = nullptr;
+    r.hasRow_ = false;
+}
+
+DbResultRow &DbResultRow::operator=(DbResultRow &&r)
+{
+    release();
+    sqlda_ = r.sqlda_;
+    fields_ = r.fields_;
+    hasRow_ = r.hasRow_;
+
+    r.sqlda_ = nullptr;
+    r.fields_ = nullptr;
+    r.hasRow_ = false;
+    return *this;
+}
+
+DbResultRow::~DbResultRow()
+{
+    release();
+}
+
+void DbResultRow::release()
+{
+    delete [] reinterpret_cast<char*>(sqlda_);
+    sqlda_ = nullptr;
+    delete [] fields_;
+    fields_ = nullptr;
+}
+
+DbResultRow::operator bool() const
+{
+    return hasRow_;
+}
+
+DbRowProxy DbResultRow::row() const
+{
+    // values are returned as text, so there are no blobs to open
+    return DbRowProxy(hasRow_ ? sqlda_ : nullptr, 0, 0);
+}
+
+} /* namespace fb */
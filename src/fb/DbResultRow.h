@@ -0,0 +1,57 @@
+/*
+ * DbResultRow.h - a single result row that owns its field buffers
+ *
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBRESULTROW_H_
+#define DBWRAP_FB_SRC_FB_DBRESULTROW_H_
+
+#include "DbRowProxy.h"
+#include "FbCommon.h"
+
+
+namespace fb
+{
+
+class DbResultRow
+{
+    friend class DbConnection;
+public:
+    DbResultRow(DbResultRow &&r);
+    DbResultRow &operator=(DbResultRow &&r);
+    ~DbResultRow();
+
+    /** false if the statement didn't return a row */
+    explicit operator bool() const;
+
+    /** the proxy is valid as long as this object is */
+    DbRowProxy row() const;
+
+private:
+    /** takes ownership of sqlda and fields */
+    DbResultRow(SqlDescriptorArea *sqlda, unsigned char *fields, bool hasRow);
+
+    // disable copying
+    DbResultRow(const DbResultRow&) = delete;
+    DbResultRow &operator=(const DbResultRow&) = delete;
+
+    void release();
+
+    SqlDescriptorArea *sqlda_;
+    unsigned char *fields_;
+    bool hasRow_;
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBRESULTROW_H_ */
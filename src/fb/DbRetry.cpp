@@ -0,0 +1,99 @@
+/*
+ * DbRetry.cpp - run a unit of work in a transaction, retrying it on
+ *               update conflicts and deadlocks
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbRetry.h"
+
+#include <ibase.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <thread>
+
+
+namespace fb
+{
+
+DbRetryStats::DbRetryStats() : exhausted_(0)
+{
+    for (auto &r : retries_) {
+        r.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t DbRetryStats::retries(RetryableError error) const
+{
+    int idx = static_cast<int>(error);
+    if (idx < 0 || idx >= static_cast<int>(RetryableError::Count)) {
+        throw std::out_of_range("retryable error class is out of range!");
+    }
+    return retries_[idx].load(std::memory_order_relaxed);
+}
+
+uint64_t DbRetryStats::exhausted() const
+{
+    return exhausted_.load(std::memory_order_relaxed);
+}
+
+void DbRetryStats::recordRetry(RetryableError error)
+{
+    retries_[static_cast<int>(error)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void DbRetryStats::recordExhausted()
+{
+    exhausted_.fetch_add(1, std::memory_order_relaxed);
+}
+
+RetryableError classifyRetryableError(const FbException &exc)
+{
+    // an update conflict is reported as isc_deadlock followed by
+    // isc_update_conflict, so check the more specific codes first
+    if (exc.hasErrorCode(isc_update_conflict)) {
+        return RetryableError::UpdateConflict;
+    } else if (exc.hasErrorCode(isc_lock_timeout)) {
+        return RetryableError::LockTimeout;
+    } else if (exc.hasErrorCode(isc_lock_conflict)) {
+        return RetryableError::LockConflict;
+    } else if (exc.hasErrorCode(isc_deadlock)) {
+        return RetryableError::Deadlock;
+    }
+    return RetryableError::None;
+}
+
+void retryBackoff(const DbRetryOptions &options, unsigned int attempt)
+{
+    if (options.initialBackoffMs_ == 0) {
+        return;
+    }
+
+    // exponential growth capped at maxBackoffMs_, avoid shift overflow
+    unsigned int shift = std::min(attempt - 1, 20u);
+    uint64_t ceiling = static_cast<uint64_t>(options.initialBackoffMs_) << shift;
+    ceiling = std::min<uint64_t>(ceiling, std::max(options.maxBackoffMs_,
+                                                   options.initialBackoffMs_));
+
+    // full jitter: sleep a random time in [0, ceiling] so that competing
+    // writers don't retry in lock step
+    static thread_local std::minstd_rand rng(static_cast<unsigned>(
+            std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+            static_cast<size_t>(std::chrono::steady_clock::now()
+                                    .time_since_epoch().count())));
+    std::uniform_int_distribution<uint64_t> dist(0, ceiling);
+    std::this_thread::sleep_for(std::chrono::milliseconds(dist(rng)));
+}
+
+} /* namespace fb */
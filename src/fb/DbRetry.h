@@ -0,0 +1,150 @@
+/*
+ * DbRetry.h - run a unit of work in a transaction, retrying it on
+ *             update conflicts and deadlocks
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBRETRY_H_
+#define DBWRAP_FB_SRC_FB_DBRETRY_H_
+
+#include "DbConnection.h"
+#include "DbTransaction.h"
+#include "FbException.h"
+
+#include <atomic>
+#include <cstdint>
+
+
+namespace fb
+{
+
+/** classes of errors after which a transaction is worth retrying */
+enum class RetryableError : int
+{
+    None = 0,
+    Deadlock,
+    UpdateConflict,
+    LockConflict,
+    LockTimeout,
+    Count // number of error classes, keep last
+};
+
+/**
+ * retry counters, one per error class. A single instance may be
+ * shared by many threads calling `runInTransaction`.
+ */
+class DbRetryStats
+{
+public:
+    DbRetryStats();
+
+    /** how many times a transaction was retried after `error` */
+    uint64_t retries(RetryableError error) const;
+    /** how many units of work failed after using up all attempts */
+    uint64_t exhausted() const;
+
+    void recordRetry(RetryableError error);
+    void recordExhausted();
+
+private:
+    DbRetryStats(const DbRetryStats&) = delete;
+    DbRetryStats &operator=(const DbRetryStats&) = delete;
+
+    std::atomic<uint64_t> retries_[static_cast<int>(RetryableError::Count)];
+    std::atomic<uint64_t> exhausted_;
+};
+
+struct DbRetryOptions
+{
+    /** total number of attempts, including the first one */
+    unsigned int maxAttempts_;
+    /** backoff before the first retry, doubled on each further retry */
+    unsigned int initialBackoffMs_;
+    /** upper bound of the backoff between two attempts */
+    unsigned int maxBackoffMs_;
+    /** optional retry counters, not owned */
+    DbRetryStats *stats_;
+
+    explicit DbRetryOptions(unsigned int maxAttempts = 5,
+                            unsigned int initialBackoffMs = 10,
+                            unsigned int maxBackoffMs = 1000,
+                            DbRetryStats *stats = nullptr)
+              : maxAttempts_(maxAttempts),
+                initialBackoffMs_(initialBackoffMs),
+                maxBackoffMs_(maxBackoffMs),
+                stats_(stats)
+    {
+    }
+};
+
+/** map an exception to the class of retryable error it represents */
+RetryableError classifyRetryableError(const FbException &exc);
+
+/**
+ * sleep before retry number `attempt` (1 based), using an exponential
+ * backoff with full jitter
+ */
+void retryBackoff(const DbRetryOptions &options, unsigned int attempt);
+
+/**
+ * Start a read-write transaction on `connection` and call `work` with it,
+ * then commit. If `work` or the commit fail with a deadlock or an update
+ * conflict the transaction is rolled back and the whole unit of work is
+ * run again in a new transaction, at most `options.maxAttempts_` times.
+ * Other errors and the last retryable error are rethrown to the caller.
+ *
+ * \param work a callable taking a `DbTransaction&`, it may be run more
+ *  than once so it must not have side effects outside the transaction
+ */
+template <typename Work>
+void runInTransaction(DbConnection &connection,
+                      const DbRetryOptions &options,
+                      Work work)
+{
+    for (unsigned int attempt = 1; ; ++attempt) {
+        DbTransaction tr(connection.nativeHandle(), 1,
+                         DefaultTransMode::Rollback,
+                         TransStartMode::StartReadWrite);
+        try {
+            work(tr);
+            tr.commit();
+            return;
+        } catch (FbException &exc) {
+            RetryableError error = classifyRetryableError(exc);
+            if (error == RetryableError::None) {
+                throw;
+            }
+
+            if (attempt >= options.maxAttempts_) {
+                if (options.stats_) {
+                    options.stats_->recordExhausted();
+                }
+                throw;
+            }
+
+            try {
+                tr.rollback();
+            } catch (FbException &) {
+                // the transaction is gone anyway, we start a new one
+            }
+
+            if (options.stats_) {
+                options.stats_->recordRetry(error);
+            }
+        }
+        retryBackoff(options, attempt);
+    }
+}
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBRETRY_H_ */
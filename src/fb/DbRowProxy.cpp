@@ -25,17 +25,35 @@ namespace fb {
 
 DbRowProxy::DbRowProxy(SqlDescriptorArea *sqlda,
                        FbApiHandle db,
-                       FbApiHandle tr) : row_(sqlda),
+                       FbApiHandle tr,
+                       const ColumnIndex *columns /* = nullptr */) :
+                                         row_(sqlda),
                                          db_(db),
-                                         transaction_(tr)
+                                         transaction_(tr),
+                                         columns_(columns)
 {
 }
 
+DbRowProxy makeRowProxy(SqlDescriptorArea *sqlda)
+{
+    return DbRowProxy(sqlda, 0, 0);
+}
+
 unsigned int DbRowProxy::columnCount() const
 {
     return static_cast<unsigned>(row_->sqld);
 }
 
+unsigned int DbRowProxy::columnIndex(const char *name) const
+{
+    int idx = (row_ && name) ? findColumn(row_, columns_, name) : -1;
+    if (idx < 0) {
+        throw std::out_of_range(std::string("unknown result column: ") +
+                                (name ? name : "(null)"));
+    }
+    return static_cast<unsigned int>(idx);
+}
+
 bool DbRowProxy::fieldIsNull(unsigned int idx) const
 {
     if (!row_) {
@@ -24,15 +24,26 @@ namespace fb {
 
 // forward declarations
 class DbBlob;
+struct ColumnIndex;
 
 class DbRowProxy
 {
     friend class DbStatement;
+    friend class DbResultRow;
+    friend class DbParallelScan;
+    friend DbRowProxy makeRowProxy(SqlDescriptorArea *sqlda);
 public:
     /** test if this is a valid row */
     explicit operator bool() const;
 
     unsigned int columnCount() const;
+
+    /**
+     * 0 based index of the column with the given alias or field name,
+     * throws std::out_of_range if there's no such column
+     */
+    unsigned int columnIndex(const char *name) const;
+
     bool fieldIsNull(unsigned int idx) const;
     int getInt(unsigned int idx) const;
     int64_t getInt64(unsigned int idx) const;
@@ -40,12 +51,15 @@ public:
     DbBlob getBlob(unsigned int idx) const;
 
 private:
-    DbRowProxy(SqlDescriptorArea *sqlda, FbApiHandle db, FbApiHandle tr);
+    DbRowProxy(SqlDescriptorArea *sqlda, FbApiHandle db, FbApiHandle tr,
+               const ColumnIndex *columns = nullptr);
 
     /** row_ is not owned by this */
     SqlDescriptorArea *row_;
     FbApiHandle db_;
     FbApiHandle transaction_;
+    /** column name index, not owned, may be null */
+    const ColumnIndex *columns_;
 };
 
 } /* namespace fb */
@@ -0,0 +1,225 @@
+/*
+ * DbSlowQueryLog.cpp - report the statements slower than a threshold
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbSlowQueryLog.h"
+
+#include "DbTimeStamp.h"
+#include "FbInternals.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+
+namespace fb
+{
+
+namespace {
+
+struct SlowLogConfig
+{
+    std::mutex mutex_;
+    std::shared_ptr<const DbSlowQuerySink> sink_;
+    /** 0 when there's no sink */
+    std::atomic<uint64_t> thresholdNs_;
+
+    SlowLogConfig() : thresholdNs_(0)
+    {
+    }
+};
+
+/** never destroyed, statements may finish calls after static destructors ran */
+static SlowLogConfig &config()
+{
+    static SlowLogConfig *c = new SlowLogConfig;
+    return *c;
+}
+
+static std::string quoted(const char *s, size_t length)
+{
+    std::string text(1, '\'');
+    for (size_t i = 0; i != length; ++i) {
+        if (s[i] == '\'') {
+            text += '\'';
+        }
+        text += s[i];
+    }
+    text += '\'';
+    return text;
+}
+
+static std::string scaledInt(int64_t v, int scale)
+{
+    char buf[SCALED_INT_MAX_LENGTH];
+    return std::string(buf, formatScaledInt(buf, v, scale));
+}
+
+/** the value of a bound parameter as an SQL literal */
+static std::string paramLiteral(const XSQLVAR &v1)
+{
+    if (!v1.sqldata || ((v1.sqltype & 1) && v1.sqlind && *v1.sqlind == -1)) {
+        return "NULL";
+    }
+
+    char buf[32];
+    const char *data = v1.sqldata;
+    switch (v1.sqltype & ~1) {
+    case SQL_TEXT:
+        return quoted(data, static_cast<size_t>(v1.sqllen));
+    case SQL_VARYING:
+        {
+            const FbVarchar *vc = reinterpret_cast<const FbVarchar*>(data);
+            return quoted(vc->str, static_cast<size_t>(vc->length));
+        }
+    case SQL_SHORT:
+        return scaledInt(*reinterpret_cast<const short*>(data), v1.sqlscale);
+    case SQL_LONG:
+        return scaledInt(*reinterpret_cast<const ISC_LONG*>(data), v1.sqlscale);
+    case SQL_INT64:
+        return scaledInt(*reinterpret_cast<const ISC_INT64*>(data), v1.sqlscale);
+    case SQL_FLOAT:
+        snprintf(buf, sizeof(buf), "%.9g",
+                 static_cast<double>(*reinterpret_cast<const float*>(data)));
+        return buf;
+    case SQL_DOUBLE:
+    case SQL_D_FLOAT:
+        snprintf(buf, sizeof(buf), "%.17g", *reinterpret_cast<const double*>(data));
+        return buf;
+    case SQL_TYPE_DATE:
+        return "DATE '" +
+               DbDate(*reinterpret_cast<const ISC_DATE*>(data)).iso8601Date() + "'";
+    case SQL_TYPE_TIME:
+        return "TIME '" +
+               DbTime(*reinterpret_cast<const ISC_TIME*>(data)).iso8601Time() + "'";
+    case SQL_TIMESTAMP:
+        return "TIMESTAMP '" +
+               DbTimeStamp(*reinterpret_cast<const DbTimeStamp::IscTimestamp*>(data))
+                    .iso8601DateTime() + "'";
+#ifdef SQL_BOOLEAN
+    case SQL_BOOLEAN:
+        return *data ? "TRUE" : "FALSE";
+#endif
+    case SQL_BLOB:
+        return "[blob]";
+    default:
+        return "[?]";
+    }
+}
+
+} /* anonymous namespace */
+
+std::string DbSlowQuery::describe() const
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf),
+             "slow query: %.3f ms (execute %.3f ms, fetch %.3f ms), %llu rows%s\n",
+             static_cast<double>(executeNs_ + fetchNs_) / 1e6,
+             static_cast<double>(executeNs_) / 1e6,
+             static_cast<double>(fetchNs_) / 1e6,
+             static_cast<unsigned long long>(rows_),
+             failed_ ? ", failed" : "");
+
+    std::string text = buf;
+    text += "sql: ";
+    text += sql_;
+    text += '\n';
+    for (size_t i = 0; i != params_.size(); ++i) {
+        snprintf(buf, sizeof(buf), "param %u: ", static_cast<unsigned>(i + 1));
+        text += buf;
+        text += params_[i];
+        text += '\n';
+    }
+    if (!plan_.empty()) {
+        text += "plan: ";
+        text += plan_;
+        text += '\n';
+    }
+    return text;
+}
+
+void DbSlowQueryLog::setSink(DbSlowQuerySink sink, unsigned int thresholdMs)
+{
+    SlowLogConfig &c = config();
+    std::lock_guard<std::mutex> const lg(c.mutex_);
+    if (sink) {
+        c.sink_ = std::make_shared<const DbSlowQuerySink>(std::move(sink));
+        // a zero threshold would disable the log, report every call instead
+        c.thresholdNs_.store(thresholdMs ? uint64_t(thresholdMs) * 1000000 : 1,
+                             std::memory_order_relaxed);
+    } else {
+        c.thresholdNs_.store(0, std::memory_order_relaxed);
+        c.sink_.reset();
+    }
+}
+
+DbSlowQuerySink DbSlowQueryLog::stderrSink()
+{
+    return [](const DbSlowQuery &q) {
+        fputs(q.describe().c_str(), stderr);
+    };
+}
+
+uint64_t slowQueryThresholdNs()
+{
+    return config().thresholdNs_.load(std::memory_order_relaxed);
+}
+
+void reportSlowQuery(const std::string &sql,
+                     FbApiHandle statement,
+                     const XSQLDA *params,
+                     uint64_t executeNs,
+                     uint64_t fetchNs,
+                     uint64_t rows,
+                     bool failed)
+{
+    SlowLogConfig &c = config();
+    std::shared_ptr<const DbSlowQuerySink> sink;
+    {
+        std::lock_guard<std::mutex> const lg(c.mutex_);
+        sink = c.sink_;
+    }
+    if (!sink) {
+        return;
+    }
+
+    DbSlowQuery q;
+    q.sql_ = sql;
+    q.executeNs_ = executeNs;
+    q.fetchNs_ = fetchNs;
+    q.rows_ = rows;
+    q.failed_ = failed;
+
+    if (params) {
+        for (int i = 0; i != params->sqld; ++i) {
+            q.params_.push_back(paramLiteral(params->sqlvar[i]));
+        }
+    }
+
+    if (statement) {
+        try {
+            q.plan_ = statementPlan(statement);
+        } catch (std::exception &) {
+            // the plan isn't worth failing the caller's statement for
+        }
+    }
+
+    try {
+        (*sink)(q);
+    } catch (...) {
+        // calls are finished in destructors too, the sink must not throw
+    }
+}
+
+} /* namespace fb */
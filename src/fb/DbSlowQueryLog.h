@@ -0,0 +1,75 @@
+/*
+ * DbSlowQueryLog.h - report the statements slower than a threshold
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBSLOWQUERYLOG_H_
+#define DBWRAP_FB_SRC_FB_DBSLOWQUERYLOG_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+namespace fb
+{
+
+/** one slow call of a statement */
+struct DbSlowQuery
+{
+    std::string sql_;
+    /**
+     * the bound parameters as SQL literals ('text', 12, NULL), as they
+     * were when the call finished
+     */
+    std::vector<std::string> params_;
+    /** time spent in execute */
+    uint64_t executeNs_;
+    /** time spent fetching rows */
+    uint64_t fetchNs_;
+    uint64_t rows_;
+    bool failed_;
+    /** the access plan, empty for statements run by executeUpdate */
+    std::string plan_;
+
+    /** multi-line text rendering of the record */
+    std::string describe() const;
+};
+
+typedef std::function<void(const DbSlowQuery&)> DbSlowQuerySink;
+
+/**
+ * Calls of statements (an execute and the fetches that follow it)
+ * lasting longer than the threshold are reported to the sink, on the
+ * thread that ran the statement. The plan and parameters are read only
+ * for the slow calls.
+ *
+ * Calls are timed only when the library is built with DBWRAP_FB_METRICS
+ * defined (make METRICS=1).
+ */
+class DbSlowQueryLog
+{
+public:
+    /**
+     * report the calls slower than thresholdMs to sink, a null sink
+     * stops reporting, the sink may be called by several threads at once
+     */
+    static void setSink(DbSlowQuerySink sink, unsigned int thresholdMs);
+
+    /** a sink printing describe() to stderr */
+    static DbSlowQuerySink stderrSink();
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBSLOWQUERYLOG_H_ */
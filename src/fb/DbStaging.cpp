@@ -0,0 +1,192 @@
+/*
+ * DbStaging.cpp - stage client side data in a global temporary table
+ *                 so that queries can join against it
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbStaging.h"
+
+#include "DbConnection.h"
+#include "DbRowProxy.h"
+#include "DbTransaction.h"
+#include "FbException.h"
+
+#include <cctype>
+#include <cstdio>
+#include <stdexcept>
+
+
+namespace fb
+{
+
+namespace {
+
+/**
+ * upper case and single space separated column definitions, so that
+ * equivalent definitions share a table
+ */
+static std::string normalizeColumns(const char *columns)
+{
+    std::string norm;
+    for (const char *p = columns; *p; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (isspace(c)) {
+            if (!norm.empty() && norm.back() != ' ') {
+                norm += ' ';
+            }
+        } else {
+            norm += static_cast<char>(toupper(c));
+        }
+    }
+    if (!norm.empty() && norm.back() == ' ') {
+        norm.pop_back();
+    }
+    return norm;
+}
+
+/** the table name is a hash of the column definitions */
+static std::string stagingTableName(const char *columns)
+{
+    if (!columns || !*columns) {
+        throw std::invalid_argument("staging table needs at least one column!");
+    }
+
+    // 64 bit FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (char c : normalizeColumns(columns)) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ULL;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "DBWRAP_STG_%016llX",
+             static_cast<unsigned long long>(h));
+    return name;
+}
+
+/** count the commas that are not inside parentheses, e.g. NUMERIC(18,2) */
+static unsigned int countColumns(const char *columns)
+{
+    unsigned int count = 1;
+    int depth = 0;
+    for (const char *p = columns; *p; ++p) {
+        if (*p == '(') {
+            ++depth;
+        } else if (*p == ')') {
+            --depth;
+        } else if (*p == ',' && depth == 0) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+static bool tableExists(DbConnection &connection, DbTransaction &transaction,
+                        const std::string &name)
+{
+    DbStatement st = connection.createStatement(
+            "SELECT 1 FROM RDB$RELATIONS WHERE RDB$RELATION_NAME = ?",
+            &transaction);
+    st.setSingleton();
+    st.setText(1, name.c_str());
+    return static_cast<bool>(st.uniqueResult());
+}
+
+/** create the table on first use, it's then shared by all attachments */
+static void ensureTable(DbConnection &connection, DbTransaction &transaction,
+                        const std::string &name, const char *columns)
+{
+    if (tableExists(connection, transaction, name)) {
+        return;
+    }
+
+    std::string ddl = "CREATE GLOBAL TEMPORARY TABLE " + name +
+                      " (" + columns + ") ON COMMIT DELETE ROWS";
+    try {
+        // DDL is committed in its own transaction
+        connection.executeUpdate(ddl.c_str());
+    } catch (FbException &) {
+        // another attachment may have created it meanwhile
+        if (!tableExists(connection, transaction, name)) {
+            throw;
+        }
+    }
+}
+
+static DbStatement prepareInsert(DbConnection &connection,
+                                 DbTransaction &transaction,
+                                 const std::string &name,
+                                 const char *columns,
+                                 unsigned int columnCount)
+{
+    ensureTable(connection, transaction, name, columns);
+
+    std::string sql = "INSERT INTO " + name + " VALUES (";
+    for (unsigned int i = 0; i != columnCount; ++i) {
+        sql += i ? ", ?" : "?";
+    }
+    sql += ")";
+    return connection.createStatement(sql.c_str(), &transaction);
+}
+
+} /* anonymous namespace */
+
+DbStaging::DbStaging(DbConnection &connection,
+                     DbTransaction &transaction,
+                     const char *columns) :
+                        connection_(connection),
+                        transaction_(transaction),
+                        tableName_(stagingTableName(columns)),
+                        columnCount_(countColumns(columns)),
+                        rowCount_(0),
+                        insert_(prepareInsert(connection, transaction,
+                                              tableName_, columns,
+                                              columnCount_))
+{
+}
+
+const char *DbStaging::tableName() const
+{
+    return tableName_.c_str();
+}
+
+unsigned int DbStaging::columnCount() const
+{
+    return columnCount_;
+}
+
+uint64_t DbStaging::rowCount() const
+{
+    return rowCount_;
+}
+
+void DbStaging::add(const std::vector<DbParam> &row)
+{
+    if (row.size() != columnCount_) {
+        throw std::invalid_argument("staged row has the wrong number of values!");
+    }
+
+    for (size_t i = 0; i != row.size(); ++i) {
+        row[i].bind(insert_, static_cast<unsigned int>(i + 1));
+    }
+    insert_.execute();
+    ++rowCount_;
+}
+
+void DbStaging::clear()
+{
+    std::string sql = "DELETE FROM " + tableName_;
+    connection_.executeUpdate(sql.c_str(), &transaction_);
+    rowCount_ = 0;
+}
+
+} /* namespace fb */
@@ -0,0 +1,86 @@
+/*
+ * DbStaging.h - stage client side data in a global temporary table
+ *               so that queries can join against it
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBSTAGING_H_
+#define DBWRAP_FB_SRC_FB_DBSTAGING_H_
+
+#include "DbParam.h"
+#include "DbStatement.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace fb
+{
+
+// forward declarations
+class DbConnection;
+class DbTransaction;
+
+/**
+ * Rows added to a DbStaging object are inserted, with a statement
+ * prepared once, into an ON COMMIT DELETE ROWS global temporary table.
+ * Queries in the same transaction can join against tableName(), the
+ * rows are gone when the transaction commits or rolls back.
+ *
+ * The table is created on first use and shared by all DbStaging objects
+ * with the same column definitions, its name is derived from them.
+ */
+class DbStaging
+{
+public:
+    /**
+     * \param columns column definitions as in CREATE TABLE,
+     *  e.g. "ID BIGINT, NAME VARCHAR(40)"
+     * \param transaction not owned, it must be started
+     */
+    DbStaging(DbConnection &connection,
+              DbTransaction &transaction,
+              const char *columns);
+
+    const char *tableName() const;
+    unsigned int columnCount() const;
+    /** rows added since construction or the last clear */
+    uint64_t rowCount() const;
+
+    /** one value per column */
+    void add(const std::vector<DbParam> &row);
+
+    template <typename... Values>
+    void add(const Values&... values)
+    {
+        add(std::vector<DbParam>{ DbParam(values)... });
+    }
+
+    /** remove the rows added earlier in this transaction */
+    void clear();
+
+private:
+    DbStaging(const DbStaging&) = delete;
+    DbStaging &operator=(const DbStaging&) = delete;
+
+    DbConnection &connection_;
+    DbTransaction &transaction_;
+    std::string tableName_;
+    unsigned int columnCount_;
+    uint64_t rowCount_;
+    DbStatement insert_;
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBSTAGING_H_ */
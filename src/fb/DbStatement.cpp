@@ -16,6 +16,7 @@
 #include "DbStatement.h"
 
 #include "DbBlob.h"
+#include "DbProbes.h"
 #include "DbRowProxy.h"
 #include "DbTransaction.h"
 #include "FbException.h"
@@ -25,73 +26,15 @@
 
 #include <cassert>
 #include <memory>
+#include <stdexcept>
+#include <string>
 #include <string.h>
+#include <utility>
 
 
 namespace fb
 {
 
-namespace {
-
-/**
- * how much padding should we add to n so that it is a multiple of
- * blockSize (it aligns on an blockSize byte boundary)
- */
-static inline size_t pad_to_align(size_t n, size_t blockSize)
-{
-    size_t r = n % blockSize;
-    return r ? (blockSize - r) : 0;
-}
-
-/**
- * fields will look like this in the memory:
- * 0-2 short, null field indicator
- * 2-4 short, field length for VARYING fields
- * 4-x padding bytes up to a multiple of 8 bytes
- * x-(x + sqllen) the field data, exception VARYING records start at offset 2
- * @remark the caller must delete [] the returned array
- */
-static unsigned char *allocateAndSetXsqldaFields(XSQLDA *sqlda)
-{
-    size_t fsize = 0;
-    for (int i = 0; i != sqlda->sqld; ++i) {
-        XSQLVAR &v1 = sqlda->sqlvar[i];
-        //printf("Type: %d Len: %d, data: %p ind: %p, name: %s\n",
-        //        v1.sqltype, v1.sqllen, v1.sqldata, v1.sqlind, v1.sqlname);
-        fsize += pad_to_align(fsize, sizeof(ISC_SHORT));
-        fsize += (2 * sizeof(ISC_SHORT));
-        fsize += pad_to_align(fsize, 8);
-        fsize += static_cast<size_t>(v1.sqllen);
-    }
-
-    unsigned char *fields = new unsigned char[fsize];
-    memset(fields, 0, fsize);
-
-    unsigned char *p = fields;
-
-    for (int i = 0; i != sqlda->sqld; ++i) {
-        XSQLVAR &v1 = sqlda->sqlvar[i];
-        p += pad_to_align(static_cast<size_t>(p - fields), sizeof(ISC_SHORT));
-        v1.sqlind = reinterpret_cast<ISC_SHORT*>(p);
-        p += sizeof(ISC_SHORT);
-        if ((v1.sqltype & ~1) == SQL_VARYING) {
-            v1.sqldata = reinterpret_cast<ISC_SCHAR*>(p);
-            // tell the engine we have more space
-            v1.sqllen = static_cast<ISC_SHORT>(v1.sqllen
-                    + static_cast<int>(sizeof(ISC_SHORT)));
-        } else {
-            p += sizeof(ISC_SHORT);
-            p += pad_to_align(static_cast<size_t>(p - fields), 8);
-            v1.sqldata = reinterpret_cast<ISC_SCHAR*>(p);
-        }
-        p += v1.sqllen;
-    }
-    assert(p <= (fields + fsize));
-    return fields;
-}
-
-} /* anonymous namespace */
-
 DbStatement::DbStatement(FbApiHandle *db,
                          DbTransaction *tr,
                          const char *sql) :
@@ -104,9 +47,17 @@ DbStatement::DbStatement(FbApiHandle *db,
                             trans_(tr),
                             ownsTransaction_(tr == nullptr),
                             cursorOpened_(false),
-                            statementType_(0)
+                            singleton_(false),
+                            singletonRow_(false),
+                            statementType_(0),
+                            named_(),
+                            columnIndex_(nullptr),
+                            digestCall_(nullptr),
+                            stats_(nullptr)
 {
     assert(db);
+    ScopedLatency const timer(DbOperation::Prepare);
+    DBWRAP_PROBE1(prepare__start, sql);
 
     /* make sure we delete a transaction we create if the
      * constructor fails with an exception
@@ -131,8 +82,11 @@ DbStatement::DbStatement(FbApiHandle *db,
     results_->sqld = 1;
     results_->version = SQLDA_VERSION1;
 
-    if (isc_dsql_prepare(status, trans_->nativeHandle(), &statement_, 0,
-                        sql, static_cast<short>(FB_SQL_DIALECT), results_)) {
+    ISC_STATUS rc = isc_dsql_prepare(status, trans_->nativeHandle(), &statement_,
+                                     0, sql, static_cast<short>(FB_SQL_DIALECT),
+                                     results_);
+    DBWRAP_PROBE3(prepare__done, sql, statement_, rc != 0);
+    if (rc) {
         throw FbException("Failed to prepare statement.", status);
     }
 
@@ -173,6 +127,12 @@ DbStatement::DbStatement(FbApiHandle *db,
         fields_ = allocateAndSetXsqldaFields(results_);
     }
 
+    if (planWatchEnabled()) {
+        checkStatementPlan(sql, statement_);
+    }
+
+    digestCall_ = newQueryDigestCall(sql);
+
     // constructor succeeded (until here), release the transaction deleter
     transPtr.release();
 }
@@ -182,7 +142,10 @@ DbStatement::DbStatement(DbStatement &&st) :
         results_(st.results_), fields_(st.fields_), inParams_(st.inParams_),
         inFields_(st.inFields_), statement_(st.statement_), db_(st.db_),
         trans_(st.trans_), ownsTransaction_(st.ownsTransaction_),
-        cursorOpened_(st.cursorOpened_), statementType_(st.statementType_)
+        cursorOpened_(st.cursorOpened_), singleton_(st.singleton_),
+        singletonRow_(st.singletonRow_), statementType_(st.statementType_),
+        named_(std::move(st.named_)), columnIndex_(st.columnIndex_),
+        digestCall_(st.digestCall_), stats_(st.stats_)
 {
     st.results_ = nullptr;
     st.fields_ = nullptr;
@@ -190,6 +153,9 @@ DbStatement::DbStatement(DbStatement &&st) :
     st.inFields_ = nullptr;
     st.statement_ = 0;
     st.trans_ = nullptr;
+    st.columnIndex_ = nullptr;
+    st.digestCall_ = nullptr;
+    st.stats_ = nullptr;
 }
 
 /** move assignment */
@@ -205,7 +171,13 @@ DbStatement &DbStatement::operator=(DbStatement &&st)
     trans_ = st.trans_;
     ownsTransaction_ = st.ownsTransaction_;
     cursorOpened_ = st.cursorOpened_;
+    singleton_ = st.singleton_;
+    singletonRow_ = st.singletonRow_;
     statementType_ = st.statementType_;
+    named_ = std::move(st.named_);
+    columnIndex_ = st.columnIndex_;
+    digestCall_ = st.digestCall_;
+    stats_ = st.stats_;
 
     st.results_ = nullptr;
     st.fields_ = nullptr;
@@ -213,6 +185,9 @@ DbStatement &DbStatement::operator=(DbStatement &&st)
     st.inFields_ = nullptr;
     st.statement_ = 0;
     st.trans_ = nullptr;
+    st.columnIndex_ = nullptr;
+    st.digestCall_ = nullptr;
+    st.stats_ = nullptr;
 
     return *this;
 }
@@ -227,6 +202,10 @@ DbStatement::~DbStatement()
  */
 void DbStatement::close()
 {
+    // finish the last call while its parameters and plan are still there
+    delete digestCall_;
+    digestCall_ = nullptr;
+
     delete [] results_;
     results_ = nullptr;
     delete [] fields_;
@@ -235,6 +214,10 @@ void DbStatement::close()
     inParams_ = nullptr;
     delete [] inFields_;
     inFields_ = nullptr;
+    delete columnIndex_;
+    columnIndex_ = nullptr;
+    delete stats_;
+    stats_ = nullptr;
 
     ISC_STATUS_ARRAY status;
     if (statement_ != 0 &&
@@ -328,20 +311,7 @@ void DbStatement::setNull(unsigned int idx)
 
 void DbStatement::setInt(unsigned int idx, int64_t v)
 {
-    XSQLVAR &v1 = getSqlVarCheckIndex(idx, true);
-    switch (v1.sqltype & ~1) {
-    case SQL_SHORT:
-        *(reinterpret_cast<ISC_SHORT*>(v1.sqldata)) = static_cast<ISC_SHORT>(v);
-        break;
-    case SQL_LONG:
-        *(reinterpret_cast<ISC_LONG*>(v1.sqldata)) = static_cast<ISC_LONG>(v);
-        break;
-    case SQL_INT64:
-        *(reinterpret_cast<ISC_INT64*>(v1.sqldata)) = v;
-        break;
-    default:
-        throw std::invalid_argument("invalid data type for bound parameter!");
-    }
+    setIntParameter(getSqlVarCheckIndex(idx, true), v);
 }
 
 void DbStatement::setText(unsigned int idx,
@@ -354,29 +324,7 @@ void DbStatement::setText(unsigned int idx,
     }
 
     size_t len = length < 0 ? strlen(value) : static_cast<size_t>(length);
-    XSQLVAR &v1 = getSqlVarCheckIndex(idx, true);
-    FbVarchar *vc;
-
-    switch (v1.sqltype & ~1) {
-    case SQL_TEXT:
-        if (static_cast<size_t>(v1.sqllen) < len) {
-            memcpy(v1.sqldata, value, static_cast<size_t>(v1.sqllen));
-        } else {
-            memcpy(v1.sqldata, value, len);
-            memset(v1.sqldata + len, ' ', static_cast<size_t>(v1.sqllen) - len);
-        }
-        break;
-    case SQL_VARYING:
-        vc = reinterpret_cast<FbVarchar*>(v1.sqldata);
-        if ((v1.sqllen - 2) < static_cast<int>(len)) {
-            len = static_cast<size_t>(v1.sqllen - 2);
-        }
-        vc->length = static_cast<ISC_SHORT>(len);
-        memcpy(vc->str, value, len);
-        break;
-    default:
-        throw std::invalid_argument("invalid data type for bound parameter!");
-    }
+    setTextParameter(getSqlVarCheckIndex(idx, true), value, len);
 }
 
 /**
@@ -398,28 +346,180 @@ void DbStatement::setBlob(unsigned int idx, const DbBlob &blob)
     }
 }
 
+const std::vector<unsigned int> &DbStatement::namedParamPositions(
+                                                const char *name) const
+{
+    if (!named_ || !name) {
+        throw std::logic_error("statement has no named parameters!");
+    }
+
+    auto i = named_->params_.find(name);
+    if (i == named_->params_.end()) {
+        throw std::out_of_range(std::string("unknown statement parameter: ") + name);
+    }
+    return i->second;
+}
+
+void DbStatement::setNull(const char *name)
+{
+    for (unsigned int idx : namedParamPositions(name)) {
+        setNull(idx);
+    }
+}
+
+void DbStatement::setInt(const char *name, int64_t v)
+{
+    for (unsigned int idx : namedParamPositions(name)) {
+        setInt(idx, v);
+    }
+}
+
+void DbStatement::setText(const char *name, const char *value,
+                          int length /* = -1 */)
+{
+    if (value && length < 0) {
+        length = static_cast<int>(strlen(value));
+    }
+
+    for (unsigned int idx : namedParamPositions(name)) {
+        setText(idx, value, length);
+    }
+}
+
+void DbStatement::setBlob(const char *name, const DbBlob &blob)
+{
+    for (unsigned int idx : namedParamPositions(name)) {
+        setBlob(idx, blob);
+    }
+}
+
+void DbStatement::setSingleton(bool singleton /* = true */)
+{
+    singleton_ = singleton;
+}
+
+bool DbStatement::isSingleton() const
+{
+    return singleton_;
+}
 
 void DbStatement::execute()
 {
     assert(statement_ != 0);
+    if (stats_) {
+        readDatabaseCounters(db_, stats_->reply_, stats_->baseline_);
+    }
+
+    ScopedLatency const timer(DbOperation::Execute);
+    QueryDigestPhase digest(digestCall_, QueryDigestCall::Execute,
+                            statement_, inParams_);
     ISC_STATUS_ARRAY status;
     ISC_STATUS rc;
 
-    if (statementType_ == isc_info_sql_stmt_select) {
+    DBWRAP_PROBE1(execute__start, statement_);
+    if (statementType_ == isc_info_sql_stmt_select && !singleton_) {
+        // the call goes on while the rows are fetched
         rc = isc_dsql_execute(status, trans_->nativeHandle(), &statement_,
                               1, inParams_);
+        DBWRAP_PROBE2(execute__done, statement_, rc);
     } else {
+        // a singleton select gets its row right away, like the
+        // RETURNING values of other statements
         rc = isc_dsql_execute2(status, trans_->nativeHandle(), &statement_,
                               1, inParams_, results_);
+        DBWRAP_PROBE2(execute__done, statement_, rc);
+        singletonRow_ = (rc == 0);
+        digest.finish();
+        if (singletonRow_ && statementType_ == isc_info_sql_stmt_select) {
+            digest.row();
+        }
+        if (rc == 100 && statementType_ == isc_info_sql_stmt_select) {
+            // the singleton select didn't find any row
+            return;
+        }
     }
 
     if (rc != 0) {
+        // a singleton select finding more rows fails with isc_sing_select_err
+        digest.fail();
         throw FbException("Failed to execute statement.", status);
     }
 }
 
+std::string DbStatement::plan() const
+{
+    if (statement_ == 0) {
+        return std::string();
+    }
+    return statementPlan(statement_);
+}
+
+void DbStatement::setCollectStats(bool collect /* = true */)
+{
+    if (collect && !stats_) {
+        stats_ = new StatementStats();
+    } else if (!collect) {
+        delete stats_;
+        stats_ = nullptr;
+    }
+}
+
+DbExecutionStats DbStatement::executionStats()
+{
+    if (!stats_) {
+        throw std::logic_error("The statement doesn't collect execution stats!");
+    }
+
+    DbExecutionStats stats;
+    if (statement_ == 0) {
+        return stats;
+    }
+
+    DatabaseCounters &now = stats_->current_;
+    readDatabaseCounters(db_, stats_->reply_, now);
+    readStatementRecords(statement_, stats);
+
+    const DatabaseCounters &base = stats_->baseline_;
+    auto diff = [](uint64_t a, uint64_t b) { return a > b ? a - b : 0; };
+    stats.pageReads_ = diff(now.reads_, base.reads_);
+    stats.pageWrites_ = diff(now.writes_, base.writes_);
+    stats.pageFetches_ = diff(now.fetches_, base.fetches_);
+    stats.pageMarks_ = diff(now.marks_, base.marks_);
+
+    // both are sorted by relation id
+    auto b = base.tableReads_.begin();
+    for (const auto &t : now.tableReads_) {
+        DbTableReads reads;
+        reads.relationId_ = t.relationId_;
+        reads.sequential_ = t.sequential_;
+        reads.indexed_ = t.indexed_;
+
+        while (b != base.tableReads_.end() && b->relationId_ < t.relationId_) {
+            ++b;
+        }
+        if (b != base.tableReads_.end() && b->relationId_ == t.relationId_) {
+            reads.sequential_ = diff(reads.sequential_, b->sequential_);
+            reads.indexed_ = diff(reads.indexed_, b->indexed_);
+        }
+        if (reads.sequential_ || reads.indexed_) {
+            stats.tables_.push_back(reads);
+        }
+    }
+
+    if (!stats.tables_.empty()) {
+        // name the tables, after the counters were read
+        nameTables(db_, *trans_->nativeHandle(), stats_->relationNames_,
+                   stats.tables_);
+    }
+    return stats;
+}
+
 void DbStatement::reset()
 {
+    if (digestCall_) {
+        digestCall_->finish();
+    }
+
     ISC_STATUS_ARRAY status;
     if (cursorOpened_ &&
         statement_ != 0 &&
@@ -468,9 +568,30 @@ DbStatement::Iterator::Iterator(DbStatement *s) : st_(s)
         return;
     }
 
+    if (st_->singleton_) {
+        // no fetch required, and no cursor to close either
+        if (!st_->singletonRow_) {
+            st_ = nullptr;
+        }
+        return;
+    }
+
     ISC_STATUS_ARRAY status;
-    ISC_STATUS rc = isc_dsql_fetch(status, &st_->statement_,
-                                    1, st_->results_);
+    ISC_STATUS rc;
+    {
+        ScopedLatency const timer(DbOperation::Fetch);
+        QueryDigestPhase digest(st_->digestCall_, QueryDigestCall::Fetch);
+        DBWRAP_PROBE1(fetch__start, st_->statement_);
+        rc = isc_dsql_fetch(status, &st_->statement_, 1, st_->results_);
+        DBWRAP_PROBE2(fetch__done, st_->statement_, rc);
+        if (rc == 0) {
+            digest.row();
+        } else if (rc == 100l) {
+            digest.finish();
+        } else {
+            digest.fail();
+        }
+    }
     if (rc != 0) {
         // we reached the end or an error occurred
         // rc == 100 means we reached the end of the cursor
@@ -497,22 +618,30 @@ DbStatement::Iterator &DbStatement::Iterator::operator++()
 {
     assert(st_);
 
-    if (st_->statementType_ != isc_info_sql_stmt_select) {
+    if (st_->statementType_ != isc_info_sql_stmt_select || st_->singleton_) {
         // we reached the end
         st_ = nullptr;
         return *this;
     }
 
+    ScopedLatency const timer(DbOperation::Fetch);
+    QueryDigestPhase digest(st_->digestCall_, QueryDigestCall::Fetch);
     ISC_STATUS_ARRAY status;
+    DBWRAP_PROBE1(fetch__start, st_->statement_);
     ISC_STATUS rc = isc_dsql_fetch(status, &st_->statement_,
                                    1, st_->results_);
+    DBWRAP_PROBE2(fetch__done, st_->statement_, rc);
     if (rc != 0) {
         // we reached the end or an error occurred
         // rc == 100 means we reached the end of the cursor
         st_ = nullptr;
         if (rc != 100l) {
+            digest.fail();
             throw FbException("Failed to fetch from statement.", status);
         }
+        digest.finish();
+    } else {
+        digest.row();
     }
     return *this;
 }
@@ -525,9 +654,13 @@ bool DbStatement::Iterator::operator!=(const DbStatement::Iterator &other) const
 DbRowProxy DbStatement::Iterator::operator*()
 {
     assert(st_);
+    if (!st_->columnIndex_ && st_->results_) {
+        st_->columnIndex_ = buildColumnIndex(st_->results_);
+    }
     return DbRowProxy(st_->results_,
                       st_->db_,
-                      *st_->trans_->nativeHandle());
+                      *st_->trans_->nativeHandle(),
+                      st_->columnIndex_);
 }
 
 } /* namespace fb */
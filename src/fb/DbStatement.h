@@ -15,8 +15,12 @@
 
 #ifndef DBWRAP_FB_SRC_DBSTATEMENT_H_
 #define DBWRAP_FB_SRC_DBSTATEMENT_H_
+#include "DbExecutionStats.h"
 #include "FbCommon.h"
 #include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
 
 namespace fb
@@ -26,11 +30,19 @@ namespace fb
 class DbRowProxy;
 class DbTransaction;
 class DbBlob;
+struct NamedSql;
+struct ColumnIndex;
+class QueryDigestCall;
+struct StatementStats;
 
 class DbStatement
 {
 public:
+    friend class DbBulkLoader;
     friend class DbConnection;
+    friend class DbExporter;
+    friend class DbMonitor;
+    friend class DbParallelScan;
 
     class Iterator
     {
@@ -80,8 +92,43 @@ public:
      */
     void setBlob(unsigned int idx, const DbBlob &blob);
 
+    /**
+     * Set the value of a named (":name") parameter, only statements
+     * created by DbConnection::createNamedStatement have named parameters.
+     * A name used more than once in the statement sets all its positions.
+     */
+    void setNull(const char *name);
+    void setInt(const char *name, int64_t v);
+    void setText(const char *name, const char *value, int length = -1);
+    void setBlob(const char *name, const DbBlob &blob);
+
+    /**
+     * Declare that a SELECT statement returns at most one row. It is
+     * then executed and fetched in a single round trip and no cursor is
+     * left open. Executing it throws an FbException if more than one row
+     * is found.
+     */
+    void setSingleton(bool singleton = true);
+    bool isSingleton() const;
+
     void execute();
     void reset();
+    /** the access plan chosen by the server for this statement */
+    std::string plan() const;
+
+    /**
+     * Read the attachment's page and table counters at the start of
+     * every execution, so that executionStats() can tell what the
+     * execution cost. Each execution then takes one more round trip.
+     */
+    void setCollectStats(bool collect = true);
+
+    /**
+     * the server side cost of the last execution until now, e.g. after
+     * all rows were fetched, setCollectStats must be enabled. The names
+     * of the tables read are looked up once per statement
+     */
+    DbExecutionStats executionStats();
     Iterator iterate();
     Iterator end() const;
     DbRowProxy uniqueResult();
@@ -91,6 +138,8 @@ private:
 
     void createBoundParametersBlock();
     XSqlVar &getSqlVarCheckIndex(unsigned int idx, bool resetNullIndicator);
+    /** 1 based positions of a named parameter */
+    const std::vector<unsigned int> &namedParamPositions(const char *name) const;
 
 
     // disable copying
@@ -113,8 +162,20 @@ private:
     DbTransaction *trans_;
     bool ownsTransaction_;
     bool cursorOpened_;
+    /** SELECT declared to return at most one row */
+    bool singleton_;
+    /** the last execution of a singleton SELECT returned a row */
+    bool singletonRow_;
     /** one of the "isc_info_sql_stmt_*" values */
     char statementType_;
+    /** named parameter positions, shared with the parse cache, null if none */
+    std::shared_ptr<const NamedSql> named_;
+    /** result column names, built on first use */
+    ColumnIndex *columnIndex_;
+    /** the call recorded in the query digest statistics, null if not recorded */
+    QueryDigestCall *digestCall_;
+    /** the execution stats state, null if not collected */
+    StatementStats *stats_;
 };
 
 } /* namespace fb */
@@ -16,11 +16,35 @@
 #include "DbTransaction.h"
 #include <ibase.h>
 #include <stdexcept>
+#include "DbProbes.h"
 #include "FbException.h"
+#include "FbInternals.h"
+#include <atomic>
 #include <cassert>
+#include <cctype>
+#include <cstring>
 
 namespace fb {
 
+namespace {
+
+/** savepoint names are inlined in SQL, accept plain identifiers only */
+static void checkSavepointName(const char *name)
+{
+    if (!name || !isalpha(static_cast<unsigned char>(*name)) ||
+        strlen(name) > 31) {
+        throw std::invalid_argument("invalid savepoint name!");
+    }
+
+    for (const char *p = name; *p; ++p) {
+        if (!isalnum(static_cast<unsigned char>(*p)) && *p != '_' && *p != '$') {
+            throw std::invalid_argument("invalid savepoint name!");
+        }
+    }
+}
+
+} /* anonymous namespace */
+
 DbTransaction::DbTransaction(
                 const FbApiHandle *databases,
                 unsigned int dbCount,
@@ -28,13 +52,17 @@ DbTransaction::DbTransaction(
                 TransStartMode startMode /*= TransStartMode::StartReadWrite*/) :
                 dbs_(databases, databases + dbCount),
                 transaction_(0),
-                transMode_(defaultMode)
+                transMode_(defaultMode),
+                autoCommit_(startMode == TransStartMode::StartAutoCommit),
+                tag_(),
+                tracked_(false)
 {
     switch (startMode) {
         case TransStartMode::StartReadOnly:
             start(true);
             break;
         case TransStartMode::StartReadWrite:
+        case TransStartMode::StartAutoCommit:
             start(false);
             break;
         case TransStartMode::DeferStart:
@@ -60,55 +88,150 @@ DbTransaction::~DbTransaction()
     }
 }
 
-// read: http://www.devrace.com/en/fibplus/articles/3292.php
 void DbTransaction::start(bool readOnly /* = false */)
+{
+    startWithTpb(readOnly, false, 0);
+}
+
+void DbTransaction::startSnapshot(bool readOnly /* = true */)
+{
+    startWithTpb(readOnly, true, 0);
+}
+
+void DbTransaction::startAtSnapshot(int64_t snapshotNumber,
+                                    bool readOnly /* = true */)
+{
+#if FB_API_VER >= 40
+    if (snapshotNumber <= 0) {
+        throw std::invalid_argument("invalid snapshot number!");
+    }
+
+    if (dbs_.size() != 1) {
+        throw std::logic_error("Snapshot numbers are per database, a shared "
+                               "snapshot needs a single database transaction!");
+    }
+
+    startWithTpb(readOnly, true, snapshotNumber);
+#else
+    (void) snapshotNumber;
+    (void) readOnly;
+    throw std::logic_error("Starting a transaction at a snapshot number "
+                           "needs the Firebird 4 client library!");
+#endif
+}
+
+int64_t DbTransaction::snapshotNumber()
+{
+#if FB_API_VER >= 40
+    if (transaction_ == 0) {
+        throw std::logic_error("The transaction is not started!");
+    }
+
+    const char request[] = { fb_info_tra_snapshot_number, isc_info_end };
+    char reply[32] = "";
+    ISC_STATUS_ARRAY status;
+    if (isc_transaction_info(status, &transaction_, sizeof(request), request,
+                             sizeof(reply), reply)) {
+        throw FbException("Failed to get the transaction snapshot number.", status);
+    }
+
+    // servers before Firebird 4 don't know the item
+    if (reply[0] != fb_info_tra_snapshot_number) {
+        throw FbException("The server doesn't support snapshot numbers.", nullptr);
+    }
+
+    const ISC_UCHAR *item = reinterpret_cast<const ISC_UCHAR*>(reply + 1);
+    short length = static_cast<short>(isc_portable_integer(item, 2));
+    return isc_portable_integer(item + 2, length);
+#else
+    throw std::logic_error("Snapshot numbers need the Firebird 4 client library!");
+#endif
+}
+
+// read: http://www.devrace.com/en/fibplus/articles/3292.php
+void DbTransaction::startWithTpb(bool readOnly, bool snapshot,
+                                 int64_t atSnapshotNumber)
 {
     if (transaction_ != 0) {
         throw std::logic_error("Can't start a transaction that is already started!");
     }
 
-    char isc_tpb[] = {
+    char isc_tpb[20] = {
             isc_tpb_version3,
-            static_cast<char>((readOnly ? isc_tpb_read : isc_tpb_write)),
-            isc_tpb_read_committed,
-            isc_tpb_no_rec_version, // isc_tpb_rec_version
-            isc_tpb_wait
-
-            // isc_tpb_concurrency,
-            // isc_tpb_shared,
-            // isc_tpb_wait,
-            // isc_tpb_lock_write
+            static_cast<char>((readOnly ? isc_tpb_read : isc_tpb_write))
     };
+    size_t tpbLength = 2;
+
+    if (snapshot) {
+        isc_tpb[tpbLength++] = isc_tpb_concurrency;
+    } else {
+        isc_tpb[tpbLength++] = isc_tpb_read_committed;
+        isc_tpb[tpbLength++] = isc_tpb_no_rec_version; // isc_tpb_rec_version
+    }
+    isc_tpb[tpbLength++] = isc_tpb_wait;
+
+    if (autoCommit_) {
+        isc_tpb[tpbLength++] = isc_tpb_autocommit;
+    }
+
+#if FB_API_VER >= 40
+    if (atSnapshotNumber != 0) {
+        // the value is a little endian (portable) integer
+        isc_tpb[tpbLength++] = isc_tpb_at_snapshot_number;
+        isc_tpb[tpbLength++] = static_cast<char>(sizeof(atSnapshotNumber));
+        uint64_t v = static_cast<uint64_t>(atSnapshotNumber);
+        for (size_t i = 0; i != sizeof(atSnapshotNumber); ++i) {
+            isc_tpb[tpbLength++] = static_cast<char>(v & 0xFF);
+            v >>= 8;
+        }
+    }
+#else
+    assert(atSnapshotNumber == 0);
+#endif
+    assert(tpbLength <= sizeof(isc_tpb));
 
     struct  ISC_TEB // do not mess with the memory layout of this structure
     {
         const ISC_LONG *db_ptr;
         ISC_LONG tpb_len;
         const char *tpb_ptr;
-
-        ISC_TEB(const FbApiHandle &db, size_t tpbLen, const char *tpb) :
-                    db_ptr(const_cast<ISC_LONG*>(reinterpret_cast<const ISC_LONG*>(&db))),
-                    tpb_len(static_cast<ISC_LONG>(tpbLen)),
-                    tpb_ptr(tpb)
-        {
-        }
     };
 
-    std::vector<ISC_TEB> dbInfo;
+    // transactions of a few databases, the usual case, start without
+    // allocating the array
+    const size_t INLINE_DBS = 4;
+    ISC_TEB inlineInfo[INLINE_DBS];
+    std::vector<ISC_TEB> manyInfo;
+    ISC_TEB *dbInfo = inlineInfo;
+    if (dbs_.size() > INLINE_DBS) {
+        manyInfo.resize(dbs_.size());
+        dbInfo = &manyInfo[0];
+    }
+
+    size_t dbCount = 0;
     for (DbSet::const_iterator i = dbs_.begin(); i != dbs_.end(); ++i) {
         const FbApiHandle &hdb = *i;
         if (hdb == 0) {
             throw std::logic_error("All databases of a transaction must be connected.");
         }
-        dbInfo.emplace_back(hdb, sizeof(isc_tpb), isc_tpb);
+        ISC_TEB &teb = dbInfo[dbCount++];
+        teb.db_ptr = reinterpret_cast<const ISC_LONG*>(&hdb);
+        teb.tpb_len = static_cast<ISC_LONG>(tpbLength);
+        teb.tpb_ptr = isc_tpb;
     }
 
+    ScopedLatency const timer(DbOperation::TransactionStart);
+    DBWRAP_PROBE1(begin__start, this);
     ISC_STATUS_ARRAY status;
-    if (isc_start_multiple(status, &transaction_,
-                           static_cast<short>(dbInfo.size()), &dbInfo[0])) {
+    ISC_STATUS rc = isc_start_multiple(status, &transaction_,
+                                       static_cast<short>(dbCount),
+                                       dbInfo);
+    DBWRAP_PROBE2(begin__done, this, rc != 0);
+    if (rc) {
         throw FbException(
                 "Failed to start transaction (isc_start_multiple)", status);
     }
+    tracked_ = trackTransaction(this, tag_);
 }
 
 void DbTransaction::commit()
@@ -118,10 +241,18 @@ void DbTransaction::commit()
         return;
     }
 
+    ScopedLatency const timer(DbOperation::Commit);
+    DBWRAP_PROBE1(commit__start, this);
     ISC_STATUS_ARRAY status;
-    if (isc_commit_transaction(status, &transaction_)) {
+    ISC_STATUS rc = isc_commit_transaction(status, &transaction_);
+    DBWRAP_PROBE2(commit__done, this, rc != 0);
+    if (rc) {
         throw FbException("failed to commit transaction!", status);
     }
+    if (tracked_) {
+        untrackTransaction(this);
+        tracked_ = false;
+    }
     assert(transaction_ == 0);
 }
 
@@ -132,8 +263,12 @@ void DbTransaction::commitRetain()
         return;
     }
 
+    ScopedLatency const timer(DbOperation::Commit);
+    DBWRAP_PROBE1(commit__start, this);
     ISC_STATUS_ARRAY status;
-    if (isc_commit_retaining(status, &transaction_)) {
+    ISC_STATUS rc = isc_commit_retaining(status, &transaction_);
+    DBWRAP_PROBE2(commit__done, this, rc != 0);
+    if (rc) {
         throw FbException("failed to commit transaction!", status);
     }
     assert(transaction_ != 0);
@@ -146,10 +281,15 @@ void DbTransaction::rollback()
         return;
     }
 
+    ScopedLatency const timer(DbOperation::Rollback);
     ISC_STATUS_ARRAY status;
     if (isc_rollback_transaction(status, &transaction_)) {
         throw FbException("failed to rollback transaction!", status);
     }
+    if (tracked_) {
+        untrackTransaction(this);
+        tracked_ = false;
+    }
     assert(transaction_ == 0);
 }
 
@@ -160,6 +300,7 @@ void DbTransaction::rollbackRetain()
         return;
     }
 
+    ScopedLatency const timer(DbOperation::Rollback);
     ISC_STATUS_ARRAY status;
     if (isc_rollback_retaining(status, &transaction_)) {
         throw FbException("failed to rollback transaction!", status);
@@ -167,9 +308,110 @@ void DbTransaction::rollbackRetain()
     assert(transaction_ != 0);
 }
 
+void DbTransaction::executeOnAllDatabases(const std::string &sql,
+                                          const char *operation)
+{
+    if (transaction_ == 0) {
+        throw std::logic_error("The transaction is not started!");
+    }
+
+    ISC_STATUS_ARRAY status;
+    for (DbSet::iterator i = dbs_.begin(); i != dbs_.end(); ++i) {
+        if (isc_dsql_execute_immediate(status, &*i, &transaction_, 0,
+                                       sql.c_str(), FB_SQL_DIALECT, nullptr)) {
+            throw FbException(operation, status);
+        }
+    }
+}
+
+void DbTransaction::savepoint(const char *name)
+{
+    checkSavepointName(name);
+    executeOnAllDatabases(std::string("SAVEPOINT ") + name,
+                          "failed to create savepoint!");
+}
+
+void DbTransaction::releaseSavepoint(const char *name)
+{
+    checkSavepointName(name);
+    executeOnAllDatabases(std::string("RELEASE SAVEPOINT ") + name,
+                          "failed to release savepoint!");
+}
+
+void DbTransaction::rollbackTo(const char *name)
+{
+    checkSavepointName(name);
+    executeOnAllDatabases(std::string("ROLLBACK TO SAVEPOINT ") + name,
+                          "failed to rollback to savepoint!");
+}
+
+void DbTransaction::setTag(const char *tag)
+{
+    tag_ = tag ? tag : "";
+    if (tracked_) {
+        retagTransaction(this, tag_);
+    }
+}
+
+const std::string &DbTransaction::tag() const
+{
+    return tag_;
+}
+
 FbApiHandle *DbTransaction::nativeHandle()
 {
     return transaction_ ? &transaction_ : nullptr;
 }
 
+DbSavepoint::DbSavepoint(DbTransaction &transaction,
+                         const char *name /* = nullptr */) :
+                                transaction_(transaction),
+                                name_(),
+                                released_(false)
+{
+    if (name) {
+        name_ = name;
+    } else {
+        static std::atomic<unsigned int> counter(0);
+        name_ = "DBWRAP_SP_" + std::to_string(++counter);
+    }
+    transaction_.savepoint(name_.c_str());
+}
+
+DbSavepoint::~DbSavepoint()
+{
+    if (released_) {
+        return;
+    }
+
+    try {
+        transaction_.rollbackTo(name_.c_str());
+        transaction_.releaseSavepoint(name_.c_str());
+    } catch (...) {
+        // destructors must not throw, the transaction itself is most
+        // likely unusable if we get here
+    }
+}
+
+void DbSavepoint::release()
+{
+    if (!released_) {
+        transaction_.releaseSavepoint(name_.c_str());
+        released_ = true;
+    }
+}
+
+void DbSavepoint::rollback()
+{
+    if (released_) {
+        throw std::logic_error("Can't rollback to a released savepoint!");
+    }
+    transaction_.rollbackTo(name_.c_str());
+}
+
+const char *DbSavepoint::name() const
+{
+    return name_.c_str();
+}
+
 } /* namespace fb */
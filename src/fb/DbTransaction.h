@@ -16,6 +16,8 @@
 #ifndef DBWRAP_FB_SRC_FB_DBTRANSACTION_H_
 #define DBWRAP_FB_SRC_FB_DBTRANSACTION_H_
 #include "FbCommon.h"
+#include <cstdint>
+#include <string>
 #include <vector>
 
 namespace fb
@@ -31,7 +33,12 @@ enum class TransStartMode
 {
     DeferStart = 0,
     StartReadOnly,
-    StartReadWrite
+    StartReadWrite,
+    /**
+     * start a read-write transaction that the server commits (retaining
+     * the transaction context) after each statement
+     */
+    StartAutoCommit
 };
 
 class DbTransaction
@@ -43,19 +50,89 @@ public:
                   TransStartMode startMode = TransStartMode::StartReadWrite);
     ~DbTransaction();
 
+    /** start a read committed transaction */
     void start(bool readOnly = false);
+
+    /**
+     * start a snapshot (concurrency) transaction, it sees the data as it
+     * was committed when it started
+     */
+    void startSnapshot(bool readOnly = true);
+
+    /**
+     * start a snapshot transaction that sees exactly the same data as the
+     * running transaction whose snapshotNumber() is given, e.g. to read
+     * one consistent state of the database on several attachments.
+     * Needs Firebird 4 (client and server) and a single database.
+     */
+    void startAtSnapshot(int64_t snapshotNumber, bool readOnly = true);
+
+    /** the snapshot number of a started snapshot transaction */
+    int64_t snapshotNumber();
+
     void commit();
     void commitRetain();
     void rollback();
     void rollbackRetain();
 
+    /**
+     * savepoints allow undoing part of the work done in a transaction,
+     * name must be a valid SQL identifier. Each call costs a single
+     * round trip per database of the transaction.
+     */
+    void savepoint(const char *name);
+    void releaseSavepoint(const char *name);
+    /** undo the work done after the savepoint, the savepoint is kept */
+    void rollbackTo(const char *name);
+
+    /**
+     * a label reported by DbTransactionWatchdog for this transaction,
+     * e.g. the name of the job running it
+     */
+    void setTag(const char *tag);
+    const std::string &tag() const;
+
     FbApiHandle *nativeHandle();
 
 private:
+    void startWithTpb(bool readOnly, bool snapshot, int64_t atSnapshotNumber);
+    void executeOnAllDatabases(const std::string &sql, const char *operation);
+
     typedef std::vector<FbApiHandle> DbSet;
     DbSet dbs_;
     FbApiHandle transaction_;
     DefaultTransMode transMode_;
+    bool autoCommit_;
+    std::string tag_;
+    /** registered with the transaction watchdogs */
+    bool tracked_;
+};
+
+/**
+ * RAII savepoint guard, unless released the work done in the transaction
+ * after the guard was created is undone when the guard is destroyed
+ */
+class DbSavepoint
+{
+public:
+    /** if name is null a unique savepoint name is generated */
+    explicit DbSavepoint(DbTransaction &transaction, const char *name = nullptr);
+    ~DbSavepoint();
+
+    /** keep the work done since the savepoint was created */
+    void release();
+    /** undo the work done since the savepoint was created, keep the guard */
+    void rollback();
+
+    const char *name() const;
+
+private:
+    DbSavepoint(const DbSavepoint&) = delete;
+    DbSavepoint &operator=(const DbSavepoint&) = delete;
+
+    DbTransaction &transaction_;
+    std::string name_;
+    bool released_;
 };
 
 } /* namespace fb */
@@ -0,0 +1,337 @@
+/*
+ * DbTransactionWatchdog.cpp - report long running transactions and a
+ *                             growing gap behind the oldest transactions
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbTransactionWatchdog.h"
+
+#include "DbConnection.h"
+#include "FbException.h"
+#include "FbInternals.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <execinfo.h>
+
+
+namespace fb
+{
+
+namespace {
+
+constexpr int MAX_STACK_DEPTH = 32;
+
+struct TrackedTransaction
+{
+    std::chrono::steady_clock::time_point startedAt_;
+    std::thread::id owner_;
+    std::string tag_;
+    void *stack_[MAX_STACK_DEPTH];
+    int stackDepth_;
+    /** passed to a long transaction callback already */
+    bool reported_;
+};
+
+struct TransactionRegistry
+{
+    /** transactions are tracked while there are watchdogs */
+    std::atomic<int> watchdogs_;
+    /** watchdogs which want the call stacks */
+    std::atomic<int> stackWatchdogs_;
+    std::mutex mutex_;
+    std::unordered_map<const DbTransaction*, TrackedTransaction> open_;
+
+    TransactionRegistry() : watchdogs_(0), stackWatchdogs_(0)
+    {
+    }
+};
+
+/** never destroyed, transactions may end after static destructors ran */
+static TransactionRegistry &registry()
+{
+    static TransactionRegistry *r = new TransactionRegistry;
+    return *r;
+}
+
+static DbOpenTransaction describe(const TrackedTransaction &t,
+                                  std::chrono::steady_clock::time_point now)
+{
+    DbOpenTransaction d;
+    d.tag_ = t.tag_;
+    d.owner_ = t.owner_;
+    d.ageMs_ = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                    now - t.startedAt_).count());
+
+    if (t.stackDepth_ > 0) {
+        char **symbols = backtrace_symbols(t.stack_, t.stackDepth_);
+        if (symbols) {
+            d.stack_.assign(symbols, symbols + t.stackDepth_);
+            free(symbols);
+        }
+    }
+    return d;
+}
+
+static bool olderFirst(const DbOpenTransaction &a, const DbOpenTransaction &b)
+{
+    return a.ageMs_ > b.ageMs_;
+}
+
+static int64_t infoInteger(const char *p, size_t length)
+{
+    return isc_portable_integer(reinterpret_cast<const ISC_UCHAR*>(p),
+                                static_cast<short>(length));
+}
+
+static void readTransactionNumbers(DbConnection &connection, DbTransactionGap &gap)
+{
+    const char request[] = {
+        isc_info_oldest_transaction, isc_info_oldest_active,
+        isc_info_oldest_snapshot, isc_info_next_transaction, isc_info_end
+    };
+    char reply[128];
+
+    const FbApiHandle *handle = connection.nativeHandle();
+    if (!handle) {
+        throw std::logic_error("The watchdog connection is closed!");
+    }
+
+    FbApiHandle db = *handle;
+    ISC_STATUS_ARRAY status;
+    if (isc_database_info(status, &db, sizeof(request), request,
+                          sizeof(reply), reply)) {
+        throw FbException("Failed to read the transaction numbers.", status);
+    }
+
+    const char *p = reply;
+    const char *end = reply + sizeof(reply);
+    while (p + 3 <= end && *p != isc_info_end && *p != isc_info_truncated) {
+        const char item = *p;
+        size_t length = static_cast<size_t>(infoInteger(p + 1, 2));
+        p += 3;
+        if (p + length > end) {
+            break;
+        }
+
+        int64_t value = infoInteger(p, length);
+        switch (item) {
+        case isc_info_oldest_transaction:
+            gap.oldestInteresting_ = value;
+            break;
+        case isc_info_oldest_active:
+            gap.oldestActive_ = value;
+            break;
+        case isc_info_oldest_snapshot:
+            gap.oldestSnapshot_ = value;
+            break;
+        case isc_info_next_transaction:
+            gap.next_ = value;
+            break;
+        default:
+            break;
+        }
+        p += length;
+    }
+}
+
+} /* anonymous namespace */
+
+bool trackTransaction(const DbTransaction *transaction, const std::string &tag)
+{
+    TransactionRegistry &r = registry();
+    if (r.watchdogs_.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+
+    TrackedTransaction t;
+    t.startedAt_ = std::chrono::steady_clock::now();
+    t.owner_ = std::this_thread::get_id();
+    t.tag_ = tag;
+    t.stackDepth_ = 0;
+    t.reported_ = false;
+    if (r.stackWatchdogs_.load(std::memory_order_relaxed) != 0) {
+        t.stackDepth_ = backtrace(t.stack_, MAX_STACK_DEPTH);
+    }
+
+    std::lock_guard<std::mutex> const lg(r.mutex_);
+    r.open_[transaction] = std::move(t);
+    return true;
+}
+
+void retagTransaction(const DbTransaction *transaction, const std::string &tag)
+{
+    TransactionRegistry &r = registry();
+    std::lock_guard<std::mutex> const lg(r.mutex_);
+    auto i = r.open_.find(transaction);
+    if (i != r.open_.end()) {
+        i->second.tag_ = tag;
+    }
+}
+
+void untrackTransaction(const DbTransaction *transaction)
+{
+    TransactionRegistry &r = registry();
+    std::lock_guard<std::mutex> const lg(r.mutex_);
+    r.open_.erase(transaction);
+}
+
+DbTransactionWatchdog::DbTransactionWatchdog(DbConnection &connection,
+                                             LongTransactionCallback onLongTransaction,
+                                             GapCallback onGap,
+                                             const DbTransactionWatchdogOptions &opts) :
+                                connection_(connection),
+                                onLongTransaction_(std::move(onLongTransaction)),
+                                onGap_(std::move(onGap)),
+                                opts_(opts),
+                                checkMutex_(),
+                                gapReported_(false),
+                                stopMutex_(),
+                                stopped_(),
+                                stop_(false),
+                                watcher_()
+{
+    if (opts_.intervalMs_ == 0) {
+        opts_.intervalMs_ = 1;
+    }
+
+    TransactionRegistry &r = registry();
+    r.watchdogs_.fetch_add(1);
+    if (opts_.captureStacks_) {
+        r.stackWatchdogs_.fetch_add(1);
+    }
+
+    watcher_ = std::thread(&DbTransactionWatchdog::watchLoop, this);
+}
+
+DbTransactionWatchdog::~DbTransactionWatchdog()
+{
+    {
+        std::lock_guard<std::mutex> const lg(stopMutex_);
+        stop_ = true;
+    }
+    stopped_.notify_all();
+    watcher_.join();
+
+    TransactionRegistry &r = registry();
+    if (opts_.captureStacks_) {
+        r.stackWatchdogs_.fetch_sub(1);
+    }
+    r.watchdogs_.fetch_sub(1);
+}
+
+void DbTransactionWatchdog::check()
+{
+    std::lock_guard<std::mutex> const lg(checkMutex_);
+
+    if (opts_.maxAgeMs_ != 0) {
+        // transactions start and end blocked on the registry mutex, so
+        // only copy the records under it and symbolize the stacks after
+        std::vector<TrackedTransaction> tracked;
+        const auto now = std::chrono::steady_clock::now();
+        {
+            TransactionRegistry &r = registry();
+            const auto maxAge = std::chrono::milliseconds(opts_.maxAgeMs_);
+
+            std::lock_guard<std::mutex> const lg(r.mutex_);
+            for (auto &i : r.open_) {
+                TrackedTransaction &t = i.second;
+                if (!t.reported_ && now - t.startedAt_ >= maxAge) {
+                    t.reported_ = true;
+                    tracked.push_back(t);
+                }
+            }
+        }
+
+        std::vector<DbOpenTransaction> longOnes;
+        longOnes.reserve(tracked.size());
+        for (const auto &t : tracked) {
+            longOnes.push_back(describe(t, now));
+        }
+        std::sort(longOnes.begin(), longOnes.end(), olderFirst);
+        if (onLongTransaction_) {
+            for (const auto &t : longOnes) {
+                onLongTransaction_(t);
+            }
+        }
+    }
+
+    if (opts_.maxTransactionGap_ != 0) {
+        DbTransactionGap gap;
+        gap.oldestInteresting_ = 0;
+        gap.oldestActive_ = 0;
+        gap.oldestSnapshot_ = 0;
+        gap.next_ = 0;
+        readTransactionNumbers(connection_, gap);
+
+        const bool over = gap.next_ - gap.oldestInteresting_ >
+                          static_cast<int64_t>(opts_.maxTransactionGap_);
+        if (over && !gapReported_) {
+            gapReported_ = true;
+            const size_t MAX_REPORTED = 5;
+            gap.oldest_ = openTransactions();
+            if (gap.oldest_.size() > MAX_REPORTED) {
+                gap.oldest_.resize(MAX_REPORTED);
+            }
+            if (onGap_) {
+                onGap_(gap);
+            }
+        } else if (!over) {
+            gapReported_ = false;
+        }
+    }
+}
+
+std::vector<DbOpenTransaction> DbTransactionWatchdog::openTransactions()
+{
+    std::vector<TrackedTransaction> tracked;
+    const auto now = std::chrono::steady_clock::now();
+    {
+        TransactionRegistry &r = registry();
+        std::lock_guard<std::mutex> const lg(r.mutex_);
+        tracked.reserve(r.open_.size());
+        for (const auto &i : r.open_) {
+            tracked.push_back(i.second);
+        }
+    }
+
+    std::vector<DbOpenTransaction> result;
+    result.reserve(tracked.size());
+    for (const auto &t : tracked) {
+        result.push_back(describe(t, now));
+    }
+    std::sort(result.begin(), result.end(), olderFirst);
+    return result;
+}
+
+void DbTransactionWatchdog::watchLoop()
+{
+    std::unique_lock<std::mutex> lk(stopMutex_);
+    while (!stopped_.wait_for(lk, std::chrono::milliseconds(opts_.intervalMs_),
+                              [this] { return stop_; })) {
+        lk.unlock();
+        try {
+            check();
+        } catch (std::exception &) {
+            // e.g. the connection was lost, try again on the next interval
+        }
+        lk.lock();
+    }
+}
+
+} /* namespace fb */
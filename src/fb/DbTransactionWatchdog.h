@@ -0,0 +1,144 @@
+/*
+ * DbTransactionWatchdog.h - report long running transactions and a
+ *                           growing gap behind the oldest transactions
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBTRANSACTIONWATCHDOG_H_
+#define DBWRAP_FB_SRC_FB_DBTRANSACTIONWATCHDOG_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace fb
+{
+
+// forward declarations
+class DbConnection;
+
+struct DbTransactionWatchdogOptions
+{
+    /** how often the transactions are checked */
+    unsigned int intervalMs_;
+    /** report transactions open for longer than this, 0 to disable */
+    unsigned int maxAgeMs_;
+    /**
+     * report when the next transaction number is this far ahead of the
+     * oldest interesting one, 0 to disable
+     */
+    uint64_t maxTransactionGap_;
+    /** record the call stack of each transaction start */
+    bool captureStacks_;
+
+    explicit DbTransactionWatchdogOptions(unsigned int intervalMs = 10000,
+                                          unsigned int maxAgeMs = 60000,
+                                          uint64_t maxTransactionGap = 10000,
+                                          bool captureStacks = false)
+              : intervalMs_(intervalMs),
+                maxAgeMs_(maxAgeMs),
+                maxTransactionGap_(maxTransactionGap),
+                captureStacks_(captureStacks)
+    {
+    }
+};
+
+/** a DbTransaction of this process that is open */
+struct DbOpenTransaction
+{
+    /** see DbTransaction::setTag */
+    std::string tag_;
+    /** the thread which started it */
+    std::thread::id owner_;
+    /** since it was started, commitRetain doesn't restart the clock */
+    uint64_t ageMs_;
+    /** the symbolized call stack of the start, if captured */
+    std::vector<std::string> stack_;
+};
+
+/** the transaction numbers of the database */
+struct DbTransactionGap
+{
+    int64_t oldestInteresting_;
+    int64_t oldestActive_;
+    int64_t oldestSnapshot_;
+    int64_t next_;
+    /** the oldest open transactions of this process, oldest first */
+    std::vector<DbOpenTransaction> oldest_;
+};
+
+/**
+ * While a watchdog exists, every DbTransaction records when and on which
+ * thread it was started (and its call stack, if asked for) until it
+ * commits or rolls back. A thread checks them every intervalMs_:
+ *  - a transaction open longer than maxAgeMs_ is passed once to the
+ *    long transaction callback
+ *  - the database's transaction numbers are read and, when the next
+ *    transaction is more than maxTransactionGap_ ahead of the oldest
+ *    interesting one, the gap callback is called with the oldest open
+ *    transactions of this process. It's called again only after the
+ *    gap closed.
+ * The callbacks run on the watchdog thread.
+ *
+ * Transactions started before the watchdog was created aren't tracked.
+ */
+class DbTransactionWatchdog
+{
+public:
+    typedef std::function<void(const DbOpenTransaction&)> LongTransactionCallback;
+    typedef std::function<void(const DbTransactionGap&)> GapCallback;
+
+    /**
+     * the connection is not owned, it must outlive the watchdog and it
+     * must not be used by other threads, either callback may be null
+     */
+    DbTransactionWatchdog(DbConnection &connection,
+                          LongTransactionCallback onLongTransaction,
+                          GapCallback onGap,
+                          const DbTransactionWatchdogOptions &opts =
+                                  DbTransactionWatchdogOptions());
+    ~DbTransactionWatchdog();
+
+    /** check right now instead of waiting for the interval */
+    void check();
+
+    /** the transactions of this process open now, oldest first */
+    static std::vector<DbOpenTransaction> openTransactions();
+
+private:
+    DbTransactionWatchdog(const DbTransactionWatchdog&) = delete;
+    DbTransactionWatchdog &operator=(const DbTransactionWatchdog&) = delete;
+
+    void watchLoop();
+
+    DbConnection &connection_;
+    LongTransactionCallback onLongTransaction_;
+    GapCallback onGap_;
+    DbTransactionWatchdogOptions opts_;
+    /** serializes the checks, they share the connection */
+    std::mutex checkMutex_;
+    /** the gap was reported and didn't close since */
+    bool gapReported_;
+    std::mutex stopMutex_;
+    std::condition_variable stopped_;
+    bool stop_;
+    std::thread watcher_;
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBTRANSACTIONWATCHDOG_H_ */
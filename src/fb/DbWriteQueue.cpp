@@ -0,0 +1,242 @@
+/*
+ * DbWriteQueue.cpp - write-behind queue, applies the writes of many
+ *                    producers in large transactions (group commit)
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#include "DbWriteQueue.h"
+
+#include "DbConnection.h"
+#include "DbStatement.h"
+#include "DbTransaction.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+
+namespace fb
+{
+
+namespace {
+
+typedef std::map<std::string, DbStatement> StatementCache;
+
+/** bind and execute one write, preparing its statement on first use */
+static void applyWrite(DbConnection &connection, DbTransaction &tr,
+                       StatementCache &statements,
+                       const std::string &sql,
+                       const std::vector<DbParam> &params)
+{
+    StatementCache::iterator i = statements.find(sql);
+    if (i == statements.end()) {
+        i = statements.emplace(sql,
+                connection.createStatement(sql.c_str(), &tr)).first;
+    }
+
+    DbStatement &st = i->second;
+    for (size_t p = 0; p != params.size(); ++p) {
+        params[p].bind(st, static_cast<unsigned int>(p + 1));
+    }
+    st.execute();
+}
+
+} /* anonymous namespace */
+
+DbWriteQueue::DbWriteQueue(DbConnection *const *connections,
+                           unsigned int connCount,
+                           const DbWriteQueueOptions &opts) :
+                                opts_(opts),
+                                mutex_(),
+                                queued_(),
+                                taken_(),
+                                applied_(),
+                                queue_(),
+                                inFlight_(0),
+                                stop_(false),
+                                committedRows_(0),
+                                committedBatches_(0),
+                                flushers_()
+{
+    if (connCount == 0) {
+        throw std::invalid_argument("A write queue needs at least one connection!");
+    }
+
+    if (opts_.maxBatchRows_ == 0) {
+        opts_.maxBatchRows_ = 1;
+    }
+
+    for (unsigned int i = 0; i != connCount; ++i) {
+        flushers_.emplace_back(&DbWriteQueue::flusherLoop, this, connections[i]);
+    }
+}
+
+DbWriteQueue::~DbWriteQueue()
+{
+    {
+        std::lock_guard<std::mutex> const lg(mutex_);
+        stop_ = true;
+    }
+    queued_.notify_all();
+
+    for (auto &t : flushers_) {
+        t.join();
+    }
+}
+
+std::future<void> DbWriteQueue::enqueue(const char *sql,
+                                        std::vector<DbParam> params)
+{
+    if (!sql) {
+        throw std::invalid_argument("Can't queue a null SQL statement!");
+    }
+
+    Item item;
+    item.sql_ = sql;
+    item.params_ = std::move(params);
+    std::future<void> result = item.done_.get_future();
+
+    size_t queued;
+    {
+        std::unique_lock<std::mutex> lk(mutex_);
+        if (opts_.maxQueuedRows_ != 0) {
+            taken_.wait(lk, [this] {
+                return stop_ || queue_.size() < opts_.maxQueuedRows_;
+            });
+        }
+
+        if (stop_) {
+            throw std::logic_error("The write queue is stopping!");
+        }
+
+        queue_.push_back(std::move(item));
+        queued = queue_.size();
+    }
+
+    // wake the flushers when a batch starts or when it is full,
+    // otherwise they are waiting for the batch window to elapse
+    if (queued == 1 || queued >= opts_.maxBatchRows_) {
+        queued_.notify_all();
+    }
+
+    return result;
+}
+
+void DbWriteQueue::flush()
+{
+    std::unique_lock<std::mutex> lk(mutex_);
+    applied_.wait(lk, [this] { return queue_.empty() && inFlight_ == 0; });
+}
+
+uint64_t DbWriteQueue::committedRows() const
+{
+    return committedRows_.load(std::memory_order_relaxed);
+}
+
+uint64_t DbWriteQueue::committedBatches() const
+{
+    return committedBatches_.load(std::memory_order_relaxed);
+}
+
+void DbWriteQueue::flusherLoop(DbConnection *connection)
+{
+    assert(connection);
+    DbTransaction tr(connection->nativeHandle(), 1,
+                     DefaultTransMode::Rollback,
+                     TransStartMode::DeferStart);
+    // statements must be closed before the transaction object goes away
+    StatementCache statements;
+
+    std::vector<Item> batch;
+    batch.reserve(opts_.maxBatchRows_);
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            queued_.wait(lk, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                // we're stopping and there's nothing left to write
+                break;
+            }
+
+            // give the other producers a chance to join this batch
+            auto deadline = std::chrono::steady_clock::now() +
+                                std::chrono::milliseconds(opts_.maxDelayMs_);
+            queued_.wait_until(lk, deadline, [this] {
+                return stop_ || queue_.size() >= opts_.maxBatchRows_;
+            });
+
+            size_t n = std::min<size_t>(queue_.size(), opts_.maxBatchRows_);
+            for (size_t i = 0; i != n; ++i) {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+            inFlight_ += n;
+        }
+        taken_.notify_all();
+
+        if (batch.empty()) {
+            // another flusher took the writes while we were waiting
+            continue;
+        }
+
+        try {
+            tr.start();
+            for (auto &item : batch) {
+                applyWrite(*connection, tr, statements, item.sql_, item.params_);
+            }
+            tr.commit();
+
+            for (auto &item : batch) {
+                item.done_.set_value();
+            }
+            committedBatches_.fetch_add(1, std::memory_order_relaxed);
+            committedRows_.fetch_add(batch.size(), std::memory_order_relaxed);
+        } catch (std::exception &) {
+            try {
+                tr.rollback();
+            } catch (std::exception &) {
+            }
+
+            // find out which writes failed by applying them one by one
+            for (auto &item : batch) {
+                try {
+                    tr.start();
+                    applyWrite(*connection, tr, statements, item.sql_, item.params_);
+                    tr.commit();
+                    item.done_.set_value();
+                    committedBatches_.fetch_add(1, std::memory_order_relaxed);
+                    committedRows_.fetch_add(1, std::memory_order_relaxed);
+                } catch (std::exception &) {
+                    try {
+                        tr.rollback();
+                    } catch (std::exception &) {
+                    }
+                    item.done_.set_exception(std::current_exception());
+                }
+            }
+        }
+
+        size_t n = batch.size();
+        batch.clear();
+        {
+            std::lock_guard<std::mutex> const lg(mutex_);
+            inFlight_ -= n;
+        }
+        applied_.notify_all();
+    }
+}
+
+} /* namespace fb */
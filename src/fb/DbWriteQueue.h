@@ -0,0 +1,121 @@
+/*
+ * DbWriteQueue.h - write-behind queue, applies the writes of many
+ *                  producers in large transactions (group commit)
+ *
+ * This is part of the "DbWrap++ for Firebird" (DbWrap++FB)
+ * C++ library for accessing Firebird databases in your C++11
+ * program.
+ *
+ * @created: Oct 18, 2026
+ *
+ * @copyright: Copyright (c) 2015 Robert Zavalczki, distributed
+ * under the terms and conditions of the Lesser GNU General
+ * Public License version 2.1
+ */
+
+#ifndef DBWRAP_FB_SRC_FB_DBWRITEQUEUE_H_
+#define DBWRAP_FB_SRC_FB_DBWRITEQUEUE_H_
+
+#include "DbParam.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace fb
+{
+
+// forward declarations
+class DbConnection;
+
+struct DbWriteQueueOptions
+{
+    /** commit after this many writes */
+    unsigned int maxBatchRows_;
+    /** commit at most this long after the oldest write of a batch was queued */
+    unsigned int maxDelayMs_;
+    /** producers block while this many writes are waiting, 0 for no limit */
+    unsigned int maxQueuedRows_;
+
+    explicit DbWriteQueueOptions(unsigned int maxBatchRows = 1000,
+                                 unsigned int maxDelayMs = 10,
+                                 unsigned int maxQueuedRows = 100000)
+              : maxBatchRows_(maxBatchRows),
+                maxDelayMs_(maxDelayMs),
+                maxQueuedRows_(maxQueuedRows)
+    {
+    }
+};
+
+/**
+ * Many producer threads enqueue parameterised writes (INSERT, UPDATE,
+ * DELETE or EXECUTE PROCEDURE), one flusher thread per connection
+ * applies them in batches, each batch in one transaction and on
+ * statements prepared once per flusher.
+ *
+ * The future returned by enqueue is ready once the write is committed.
+ * If a batch fails, its writes are retried one transaction each, so a
+ * bad write fails only its own future.
+ */
+class DbWriteQueue
+{
+public:
+    /**
+     * the connections are not owned, they must outlive the queue and
+     * must not be used by other threads while the queue is running
+     */
+    DbWriteQueue(DbConnection *const *connections,
+                 unsigned int connCount,
+                 const DbWriteQueueOptions &opts = DbWriteQueueOptions());
+
+    /** commits everything queued so far, then stops the flushers */
+    ~DbWriteQueue();
+
+    std::future<void> enqueue(const char *sql, std::vector<DbParam> params);
+
+    /** wait until every write queued so far was committed or failed */
+    void flush();
+
+    uint64_t committedRows() const;
+    uint64_t committedBatches() const;
+
+private:
+    DbWriteQueue(const DbWriteQueue&) = delete;
+    DbWriteQueue &operator=(const DbWriteQueue&) = delete;
+
+    struct Item
+    {
+        std::string sql_;
+        std::vector<DbParam> params_;
+        std::promise<void> done_;
+    };
+
+    void flusherLoop(DbConnection *connection);
+
+    DbWriteQueueOptions opts_;
+    std::mutex mutex_;
+    /** signalled when writes were queued or the queue is stopping */
+    std::condition_variable queued_;
+    /** signalled when the flushers took writes off the queue */
+    std::condition_variable taken_;
+    /** signalled when the flushers finished a batch */
+    std::condition_variable applied_;
+    std::deque<Item> queue_;
+    /** writes taken off the queue but not yet committed */
+    size_t inFlight_;
+    bool stop_;
+    std::atomic<uint64_t> committedRows_;
+    std::atomic<uint64_t> committedBatches_;
+    std::vector<std::thread> flushers_;
+};
+
+} /* namespace fb */
+
+#endif /* DBWRAP_FB_SRC_FB_DBWRITEQUEUE_H_ */
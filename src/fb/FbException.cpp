@@ -13,15 +13,17 @@
  */
 
 #include "FbException.h"
+#include "DbProbes.h"
 #include <ibase.h>
-
+#include <algorithm>
 
 
 namespace fb {
 
 /** status should be an ISC_STATUS_ARRAY from ibase.h */
 FbException::FbException(const char *operation, const intptr_t *status) :
-                                std::runtime_error("Firebird exception!")
+                                std::runtime_error("Firebird exception!"),
+                                sqlCode_(0)
 {
     if (!status) {
         what_ = "Firebird exception";
@@ -29,11 +31,30 @@ FbException::FbException(const char *operation, const intptr_t *status) :
             what_ += ": ";
             what_ += operation;
         }
+        DBWRAP_PROBE2(exception, sqlCode_, what_.c_str());
         return;
     }
 
+    // remember the error codes so callers can tell errors apart
+    // without parsing the message
+    for (const ISC_STATUS *s = status; *s != isc_arg_end; ) {
+        switch (*s) {
+        case isc_arg_gds:
+            errorCodes_.push_back(s[1]);
+            s += 2;
+            break;
+        case isc_arg_cstring:
+            s += 3;
+            break;
+        default:
+            s += 2;
+            break;
+        }
+    }
+
     char buffer[1024];
     ISC_LONG sqlCode = isc_sqlcode(status);
+    sqlCode_ = sqlCode;
     if (sqlCode != -999) {
         snprintf(buffer, sizeof(buffer), "SQL Code: %d\n", static_cast<int>(sqlCode));
         what_ += buffer;
@@ -47,6 +68,7 @@ FbException::FbException(const char *operation, const intptr_t *status) :
         what_ += buffer;
         what_ += "\n";
     }
+    DBWRAP_PROBE2(exception, sqlCode_, what_.c_str());
 }
 
 FbException::~FbException() noexcept
@@ -58,4 +80,20 @@ const char *FbException::what() const noexcept
     return what_.c_str();
 }
 
+long FbException::sqlCode() const
+{
+    return sqlCode_;
+}
+
+intptr_t FbException::errorCode() const
+{
+    return errorCodes_.empty() ? 0 : errorCodes_.front();
+}
+
+bool FbException::hasErrorCode(intptr_t code) const
+{
+    return std::find(errorCodes_.begin(), errorCodes_.end(), code) !=
+                errorCodes_.end();
+}
+
 } /* namespace fb */
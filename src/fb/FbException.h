@@ -17,6 +17,7 @@
 
 #include <cstdint>
 #include <stdexcept>
+#include <vector>
 
 
 namespace fb {
@@ -31,8 +32,20 @@ public:
     virtual ~FbException() noexcept override;
     virtual const char *what() const noexcept override;
 
+    /** SQL code of the error, 0 if the exception has no status vector */
+    long sqlCode() const;
+
+    /** first (most significant) isc_* error code, 0 if none */
+    intptr_t errorCode() const;
+
+    /** test if the status vector contained the isc_* error code */
+    bool hasErrorCode(intptr_t code) const;
+
 private:
     std::string what_;
+    long sqlCode_;
+    /** isc_arg_gds codes extracted from the status vector */
+    std::vector<intptr_t> errorCodes_;
 };
 
 } /* namespace fb */
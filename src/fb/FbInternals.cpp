@@ -14,6 +14,361 @@
 
 #include "FbInternals.h"
 
+#include "FbException.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
 namespace fb {
 
+/**
+ * fields will look like this in the memory:
+ * 0-2 short, null field indicator
+ * 2-4 short, field length for VARYING fields
+ * 4-x padding bytes up to a multiple of 8 bytes
+ * x-(x + sqllen) the field data, exception VARYING records start at offset 2
+ * @remark the caller must delete [] the returned array
+ */
+unsigned char *allocateAndSetXsqldaFields(XSQLDA *sqlda,
+                                          size_t *bufferSize /* = nullptr */)
+{
+    size_t fsize = 0;
+    for (int i = 0; i != sqlda->sqld; ++i) {
+        XSQLVAR &v1 = sqlda->sqlvar[i];
+        //printf("Type: %d Len: %d, data: %p ind: %p, name: %s\n",
+        //        v1.sqltype, v1.sqllen, v1.sqldata, v1.sqlind, v1.sqlname);
+        fsize += pad_to_align(fsize, sizeof(ISC_SHORT));
+        fsize += (2 * sizeof(ISC_SHORT));
+        fsize += pad_to_align(fsize, 8);
+        fsize += static_cast<size_t>(v1.sqllen);
+    }
+
+    unsigned char *fields = new unsigned char[fsize];
+    memset(fields, 0, fsize);
+
+    unsigned char *p = fields;
+
+    for (int i = 0; i != sqlda->sqld; ++i) {
+        XSQLVAR &v1 = sqlda->sqlvar[i];
+        p += pad_to_align(static_cast<size_t>(p - fields), sizeof(ISC_SHORT));
+        v1.sqlind = reinterpret_cast<ISC_SHORT*>(p);
+        p += sizeof(ISC_SHORT);
+        if ((v1.sqltype & ~1) == SQL_VARYING) {
+            v1.sqldata = reinterpret_cast<ISC_SCHAR*>(p);
+            // tell the engine we have more space
+            v1.sqllen = static_cast<ISC_SHORT>(v1.sqllen
+                    + static_cast<int>(sizeof(ISC_SHORT)));
+        } else {
+            p += sizeof(ISC_SHORT);
+            p += pad_to_align(static_cast<size_t>(p - fields), 8);
+            v1.sqldata = reinterpret_cast<ISC_SCHAR*>(p);
+        }
+        p += v1.sqllen;
+    }
+    assert(p <= (fields + fsize));
+
+    if (bufferSize) {
+        *bufferSize = fsize;
+    }
+    return fields;
+}
+
+void setIntParameter(XSQLVAR &v1, int64_t v)
+{
+    switch (v1.sqltype & ~1) {
+    case SQL_SHORT:
+        *(reinterpret_cast<ISC_SHORT*>(v1.sqldata)) = static_cast<ISC_SHORT>(v);
+        break;
+    case SQL_LONG:
+        *(reinterpret_cast<ISC_LONG*>(v1.sqldata)) = static_cast<ISC_LONG>(v);
+        break;
+    case SQL_INT64:
+        *(reinterpret_cast<ISC_INT64*>(v1.sqldata)) = v;
+        break;
+    default:
+        throw std::invalid_argument("invalid data type for bound parameter!");
+    }
+}
+
+void setTextParameter(XSQLVAR &v1, const char *value, size_t length)
+{
+    FbVarchar *vc;
+
+    switch (v1.sqltype & ~1) {
+    case SQL_TEXT:
+        if (static_cast<size_t>(v1.sqllen) < length) {
+            memcpy(v1.sqldata, value, static_cast<size_t>(v1.sqllen));
+        } else {
+            memcpy(v1.sqldata, value, length);
+            memset(v1.sqldata + length, ' ', static_cast<size_t>(v1.sqllen) - length);
+        }
+        break;
+    case SQL_VARYING:
+        vc = reinterpret_cast<FbVarchar*>(v1.sqldata);
+        if ((v1.sqllen - 2) < static_cast<int>(length)) {
+            length = static_cast<size_t>(v1.sqllen - 2);
+        }
+        vc->length = static_cast<ISC_SHORT>(length);
+        memcpy(vc->str, value, length);
+        break;
+    default:
+        throw std::invalid_argument("invalid data type for bound parameter!");
+    }
+}
+
+char *formatScaledInt(char *out, int64_t v, int scale)
+{
+    const size_t MAX_FRACTION = 18;
+    size_t fraction = scale < 0 ? static_cast<size_t>(-static_cast<int64_t>(scale)) : 0;
+    if (fraction > MAX_FRACTION) {
+        fraction = MAX_FRACTION;
+    }
+
+    // 19 digits of the magnitude, or a zero and the fraction digits
+    char digits[MAX_FRACTION + 1];
+    size_t n = 0;
+    uint64_t m = v < 0 ? uint64_t(0) - static_cast<uint64_t>(v)
+                       : static_cast<uint64_t>(v);
+    do {
+        digits[n++] = static_cast<char>('0' + m % 10);
+        m /= 10;
+    } while (m != 0);
+
+    while (n <= fraction) {
+        // at least one digit before the point
+        digits[n++] = '0';
+    }
+
+    if (v < 0) {
+        *out++ = '-';
+    }
+    while (n > fraction) {
+        *out++ = digits[--n];
+    }
+    if (fraction != 0) {
+        *out++ = '.';
+        while (n != 0) {
+            *out++ = digits[--n];
+        }
+    }
+    return out;
+}
+
+SqlDescriptorArea *cloneXsqlda(const XSQLDA *sqlda)
+{
+    assert(sqlda);
+    const size_t length = XSQLDA_LENGTH(sqlda->sqld);
+    char *copy = new char[length];
+    memcpy(copy, sqlda, length);
+
+    SqlDescriptorArea *result = reinterpret_cast<SqlDescriptorArea*>(copy);
+    result->sqln = sqlda->sqld;
+    return result;
+}
+
+size_t xsqldaFieldsSize(const XSQLDA *sqlda, const unsigned char *fields)
+{
+    size_t fsize = 0;
+    for (int i = 0; i != sqlda->sqld; ++i) {
+        const XSQLVAR &v1 = sqlda->sqlvar[i];
+        const unsigned char *data = reinterpret_cast<const unsigned char*>(v1.sqldata);
+        fsize = std::max(fsize, static_cast<size_t>(data - fields) +
+                                static_cast<size_t>(v1.sqllen));
+    }
+    return fsize;
+}
+
+void rebaseXsqldaFields(XSQLDA *sqlda, const unsigned char *from,
+                        unsigned char *to)
+{
+    for (int i = 0; i != sqlda->sqld; ++i) {
+        XSQLVAR &v1 = sqlda->sqlvar[i];
+        const unsigned char *data = reinterpret_cast<const unsigned char*>(v1.sqldata);
+        const unsigned char *ind = reinterpret_cast<const unsigned char*>(v1.sqlind);
+        v1.sqldata = reinterpret_cast<ISC_SCHAR*>(to + (data - from));
+        v1.sqlind = reinterpret_cast<ISC_SHORT*>(to + (ind - from));
+    }
+}
+
+namespace {
+
+inline bool isNameStart(char c)
+{
+    return isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+inline bool isNameChar(char c)
+{
+    return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+/** skip a string literal or quoted identifier starting at p */
+const char *skipQuoted(const char *p)
+{
+    const char quote = *p++;
+    while (*p) {
+        if (*p == quote) {
+            if (p[1] != quote) {
+                return p + 1;
+            }
+            // doubled quote, an escaped quote character
+            ++p;
+        }
+        ++p;
+    }
+    return p;
+}
+
+NamedSql *rewriteNamedSql(const char *sql)
+{
+    std::unique_ptr<NamedSql> named(new NamedSql);
+    std::string &out = named->sql_;
+    out.reserve(strlen(sql));
+    unsigned int position = 0;
+
+    const char *p = sql;
+    while (*p) {
+        const char *start = p;
+        if ((p = skipLiteralOrComment(p)) != start) {
+            // copied as is
+        } else if (*p == '?') {
+            ++position;
+            ++p;
+        } else if (*p == ':' && isNameStart(p[1])) {
+            const char *name = ++p;
+            while (isNameChar(*p)) {
+                ++p;
+            }
+            named->params_[std::string(name, static_cast<size_t>(p - name))]
+                    .push_back(++position);
+            out += '?';
+            continue;
+        } else {
+            ++p;
+        }
+        out.append(start, static_cast<size_t>(p - start));
+    }
+    return named.release();
+}
+
+} /* anonymous namespace */
+
+const char *skipLiteralOrComment(const char *p)
+{
+    if (*p == '\'' || *p == '"') {
+        return skipQuoted(p);
+    } else if (p[0] == '-' && p[1] == '-') {
+        return p + strcspn(p, "\n");
+    } else if (p[0] == '/' && p[1] == '*') {
+        const char *e = strstr(p + 2, "*/");
+        return e ? e + 2 : p + strlen(p);
+    }
+    return p;
+}
+
+std::shared_ptr<const NamedSql> parseNamedSql(const char *sql)
+{
+    typedef std::unordered_map<std::string, std::shared_ptr<const NamedSql>> Cache;
+    static std::mutex cacheMutex;
+    static Cache cache;
+
+    {
+        std::lock_guard<std::mutex> const lg(cacheMutex);
+        Cache::iterator i = cache.find(sql);
+        if (i != cache.end()) {
+            return i->second;
+        }
+    }
+
+    // parsed outside the lock, a statement built from inline values
+    // isn't cached once the cache is full
+    std::shared_ptr<const NamedSql> named(rewriteNamedSql(sql));
+    std::lock_guard<std::mutex> const lg(cacheMutex);
+    if (cache.size() < MAX_NAMED_SQL) {
+        return cache.emplace(sql, named).first->second;
+    }
+    return named;
+}
+
+ColumnIndex *buildColumnIndex(const XSQLDA *sqlda)
+{
+    ColumnIndex *index = new ColumnIndex;
+    for (int i = 0; i != sqlda->sqld; ++i) {
+        const XSQLVAR &v1 = sqlda->sqlvar[i];
+        // the first column with a given name wins
+        index->names_.emplace(std::string(v1.aliasname,
+                    static_cast<size_t>(v1.aliasname_length)),
+                static_cast<unsigned int>(i));
+        index->names_.emplace(std::string(v1.sqlname,
+                    static_cast<size_t>(v1.sqlname_length)),
+                static_cast<unsigned int>(i));
+    }
+    return index;
+}
+
+int findColumn(const XSQLDA *sqlda, const ColumnIndex *index, const char *name)
+{
+    std::string key(name);
+    for (int pass = 0; pass != 2; ++pass) {
+        if (index) {
+            auto i = index->names_.find(key);
+            if (i != index->names_.end()) {
+                return static_cast<int>(i->second);
+            }
+        } else {
+            for (int i = 0; i != sqlda->sqld; ++i) {
+                const XSQLVAR &v1 = sqlda->sqlvar[i];
+                if (key.compare(0, std::string::npos, v1.aliasname,
+                                static_cast<size_t>(v1.aliasname_length)) == 0 ||
+                    key.compare(0, std::string::npos, v1.sqlname,
+                                static_cast<size_t>(v1.sqlname_length)) == 0) {
+                    return i;
+                }
+            }
+        }
+        std::transform(key.begin(), key.end(), key.begin(), [](char c) {
+            return static_cast<char>(toupper(static_cast<unsigned char>(c)));
+        });
+    }
+    return -1;
+}
+
+std::string statementPlan(FbApiHandle statement)
+{
+    const char request[] = { isc_info_sql_get_plan };
+    std::vector<char> reply(1024);
+
+    while (true) {
+        ISC_STATUS_ARRAY status;
+        if (isc_dsql_sql_info(status, &statement, sizeof(request), request,
+                              static_cast<short>(reply.size()), &reply[0])) {
+            throw FbException("Failed to get the statement plan.", status);
+        }
+
+        if (reply[0] == isc_info_truncated && reply.size() < SHRT_MAX) {
+            reply.resize(std::min<size_t>(reply.size() * 4, SHRT_MAX));
+            continue;
+        }
+        if (reply[0] != isc_info_sql_get_plan) {
+            return std::string();
+        }
+
+        size_t length = static_cast<size_t>(isc_portable_integer(
+                reinterpret_cast<const ISC_UCHAR*>(&reply[1]), 2));
+        length = std::min(length, reply.size() - 3);
+        const char *plan = &reply[3];
+        while (length && (*plan == '\n' || *plan == '\r')) {
+            ++plan;
+            --length;
+        }
+        return std::string(plan, length);
+    }
+}
+
 } /* namespace fb */
@@ -14,7 +14,21 @@
 
 #ifndef DBWRAP_FB_FBINTERNALS_H_
 #define DBWRAP_FB_FBINTERNALS_H_
+#include "DbMetrics.h"
+#include "FbCommon.h"
+
 #include <ibase.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef DBWRAP_FB_METRICS
+#include <chrono>
+#endif
 
 namespace fb {
 
@@ -37,6 +51,403 @@ struct XSqlVar : public XSQLVAR
 {
 };
 
+/**
+ * how much padding should we add to n so that it is a multiple of
+ * blockSize (it aligns on an blockSize byte boundary)
+ */
+inline size_t pad_to_align(size_t n, size_t blockSize)
+{
+    size_t r = n % blockSize;
+    return r ? (blockSize - r) : 0;
+}
+
+/**
+ * allocate a buffer for the field values described by sqlda and point
+ * the sqldata and sqlind members of its variables into it
+ * \param bufferSize if not null it receives the size of the buffer
+ * @remark the caller must delete [] the returned array
+ */
+unsigned char *allocateAndSetXsqldaFields(XSQLDA *sqlda,
+                                          size_t *bufferSize = nullptr);
+
+/**
+ * copy the variable descriptions of sqlda, the copy's data pointers
+ * still point into the original field buffer
+ * @remark the caller must delete [] (as a char array) the returned copy
+ */
+SqlDescriptorArea *cloneXsqlda(const XSQLDA *sqlda);
+
+/**
+ * size of the field buffer of sqlda, set up by allocateAndSetXsqldaFields,
+ * that holds the values of a row
+ */
+size_t xsqldaFieldsSize(const XSQLDA *sqlda, const unsigned char *fields);
+
+/**
+ * point the sqldata and sqlind members of sqlda from the field buffer
+ * "from" to the same offsets in the field buffer "to"
+ */
+void rebaseXsqldaFields(XSQLDA *sqlda, const unsigned char *from,
+                        unsigned char *to);
+
+/**
+ * store v in a SMALLINT, INTEGER or BIGINT parameter, throws
+ * std::invalid_argument for other types
+ */
+void setIntParameter(XSQLVAR &v1, int64_t v);
+
+/**
+ * store value in a CHAR (blank padded) or VARCHAR parameter, it's
+ * truncated if it doesn't fit, throws std::invalid_argument for other types
+ */
+void setTextParameter(XSQLVAR &v1, const char *value, size_t length);
+
+/** the longest text written by formatScaledInt */
+constexpr size_t SCALED_INT_MAX_LENGTH = 21;
+
+/**
+ * write v in decimal with a point -scale digits from the right, the
+ * value of a SMALLINT, INTEGER or BIGINT column of that scale. Scales
+ * below -18, more than a NUMERIC(18) has, are taken as -18. out must
+ * have room for SCALED_INT_MAX_LENGTH characters, no null is written
+ * \return a pointer past the last character written
+ */
+char *formatScaledInt(char *out, int64_t v, int scale);
+
+/**
+ * The binary row format of DbExporter, read by DbBulkLoader. Numbers
+ * are in the byte order of the machine. The file starts with:
+ *   BINARY_ROWS_MAGIC (8 bytes), uint16 column count,
+ *   per column: int16 type (XSQLVAR sqltype without the null bit),
+ *   int16 scale, uint16 length (sqllen, VARYING without the length
+ *   prefix), uint8 name length, the name (alias) bytes
+ * and is followed by rows:
+ *   uint32 length of the rest of the row,
+ *   per column: uint8 null flag (1 for null) and, if not null, the
+ *   value: uint16 length and the bytes for text (CHAR and VARCHAR),
+ *   else the XSQLVAR data as is (length bytes)
+ */
+constexpr char BINARY_ROWS_MAGIC[] = "DBWRAPB1";
+constexpr size_t BINARY_ROWS_MAGIC_LENGTH = 8;
+
+/**
+ * if p points to a string literal, a quoted identifier or a comment
+ * return a pointer past its end, else return p
+ */
+const char *skipLiteralOrComment(const char *p);
+
+/**
+ * SQL with named (":name") parameters rewritten to positional ('?')
+ * ones, params_ maps each name to its 1 based positions
+ */
+struct NamedSql
+{
+    std::string sql_;
+    std::unordered_map<std::string, std::vector<unsigned int>> params_;
+};
+
+/** the most SQL texts parseNamedSql remembers */
+constexpr size_t MAX_NAMED_SQL = 5000;
+
+/**
+ * rewrite the named parameters of sql, the first MAX_NAMED_SQL distinct
+ * SQL texts are cached for the lifetime of the program so each of them
+ * is parsed once, later ones are parsed on every call
+ */
+std::shared_ptr<const NamedSql> parseNamedSql(const char *sql);
+
+/** result column names (alias and field name) mapped to 0 based indexes */
+struct ColumnIndex
+{
+    std::unordered_map<std::string, unsigned int> names_;
+};
+
+/** @remark the caller must delete the returned object */
+ColumnIndex *buildColumnIndex(const XSQLDA *sqlda);
+
+/**
+ * look up a column by name, unquoted names are upper case in the
+ * database so the upper case name is tried if there's no exact match
+ * \return the 0 based column index or -1 if not found
+ */
+int findColumn(const XSQLDA *sqlda, const ColumnIndex *index, const char *name);
+
+/** add one latency sample of op to the calling thread's histograms */
+void recordLatency(DbOperation op, uint64_t ns);
+
+/**
+ * records the lifetime of the object as one op, it compiles to nothing
+ * unless the library is built with DBWRAP_FB_METRICS
+ */
+class ScopedLatency
+{
+public:
+#ifdef DBWRAP_FB_METRICS
+    explicit ScopedLatency(DbOperation op) : op_(op),
+                                             start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedLatency()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        recordLatency(op_, static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+private:
+    DbOperation op_;
+    std::chrono::steady_clock::time_point start_;
+#else
+    explicit ScopedLatency(DbOperation)
+    {
+    }
+#endif
+};
+
+class DbRowProxy;
+
+/**
+ * a row proxy over the values of sqlda, without a database or a
+ * transaction, so its blob columns can't be opened
+ */
+DbRowProxy makeRowProxy(SqlDescriptorArea *sqlda);
+
+/**
+ * the access plan of a prepared statement, as returned by
+ * isc_info_sql_get_plan without the leading new line
+ */
+std::string statementPlan(FbApiHandle statement);
+
+struct DbExecutionStats;
+struct DbTableReads;
+class DbTransaction;
+
+/** the records read from one table by an attachment */
+struct TableReadCounts
+{
+    unsigned int relationId_;
+    uint64_t sequential_;
+    uint64_t indexed_;
+};
+
+/** the performance counters of an attachment (isc_database_info) */
+struct DatabaseCounters
+{
+    uint64_t reads_;
+    uint64_t writes_;
+    uint64_t fetches_;
+    uint64_t marks_;
+    /** record reads by table, sorted by relation id */
+    std::vector<TableReadCounts> tableReads_;
+
+    DatabaseCounters() : reads_(0), writes_(0), fetches_(0), marks_(0),
+                         tableReads_()
+    {
+    }
+};
+
+/**
+ * read the counters of the attachment into counters, reply is the
+ * buffer of the isc_database_info reply, grown if it's too small. Both
+ * are reused, so reading the counters again doesn't allocate
+ */
+void readDatabaseCounters(FbApiHandle db, std::vector<char> &reply,
+                          DatabaseCounters &counters);
+
+/** what a statement collecting execution stats keeps between calls */
+struct StatementStats
+{
+    /** the counters at the start of the last execution */
+    DatabaseCounters baseline_;
+    /** the counters read by the last executionStats call */
+    DatabaseCounters current_;
+    /** the isc_database_info reply buffer */
+    std::vector<char> reply_;
+    /** table names by relation id, each looked up once */
+    std::unordered_map<unsigned int, std::string> relationNames_;
+};
+
+/**
+ * set the names of tables, the relation ids not in names are looked up
+ * in RDB$RELATIONS with the transaction and added to it. The query
+ * isn't recorded in the query statistics nor checked by DbPlanWatch
+ */
+void nameTables(FbApiHandle db, FbApiHandle transaction,
+                std::unordered_map<unsigned int, std::string> &names,
+                std::vector<DbTableReads> &tables);
+
+/** the record counts of the statement's last execution (isc_info_sql_records) */
+void readStatementRecords(FbApiHandle statement, DbExecutionStats &stats);
+
+/** true if DbPlanWatch is enabled */
+bool planWatchEnabled();
+
+/** compare the plan of a statement just prepared with its last plan */
+void checkStatementPlan(const char *sql, FbApiHandle statement);
+
+/**
+ * register a transaction just started with the transaction watchdogs,
+ * false if there are none and it wasn't registered
+ */
+bool trackTransaction(const DbTransaction *transaction, const std::string &tag);
+void retagTransaction(const DbTransaction *transaction, const std::string &tag);
+void untrackTransaction(const DbTransaction *transaction);
+
+/** the threshold of the slow query log, 0 if it's disabled */
+uint64_t slowQueryThresholdNs();
+
+/** report a slow call to the sink of the slow query log */
+void reportSlowQuery(const std::string &sql,
+                     FbApiHandle statement,
+                     const XSQLDA *params,
+                     uint64_t executeNs,
+                     uint64_t fetchNs,
+                     uint64_t rows,
+                     bool failed);
+
+/** the statistics of one query digest, see DbQueryStats */
+struct QueryDigest;
+
+/**
+ * one call of a statement, an execute and the fetches that follow it,
+ * added to the statistics of its query digest and reported to the slow
+ * query log when finished
+ */
+class QueryDigestCall
+{
+public:
+    enum Phase
+    {
+        Execute,
+        Fetch
+    };
+
+    QueryDigestCall(QueryDigest *digest, const char *sql);
+    /** finishes an open call */
+    ~QueryDigestCall();
+
+    /**
+     * finish the previous call, if still open, and start a new one of
+     * the statement (0 for immediate statements) with the bound params
+     */
+    void begin(FbApiHandle statement, const XSQLDA *params);
+    void add(Phase phase, uint64_t ns)
+    {
+        (phase == Execute ? executeNs_ : fetchNs_) += ns;
+    }
+    void addRow()
+    {
+        ++rows_;
+    }
+    void finish(bool failed = false);
+
+private:
+    QueryDigestCall(const QueryDigestCall&) = delete;
+    QueryDigestCall &operator=(const QueryDigestCall&) = delete;
+
+    QueryDigest *digest_;
+    std::string sql_;
+    FbApiHandle statement_;
+    const XSQLDA *params_;
+    uint64_t executeNs_;
+    uint64_t fetchNs_;
+    uint64_t rows_;
+    bool open_;
+};
+
+/**
+ * the call recording the statistics of sql, null unless the library is
+ * built with DBWRAP_FB_METRICS
+ * @remark the caller must delete the returned object
+ */
+#ifdef DBWRAP_FB_METRICS
+QueryDigestCall *newQueryDigestCall(const char *sql);
+#else
+inline QueryDigestCall *newQueryDigestCall(const char *)
+{
+    return nullptr;
+}
+#endif
+
+/**
+ * adds its lifetime to a call, which it may begin or finish, it
+ * compiles to nothing unless the library is built with DBWRAP_FB_METRICS
+ */
+class QueryDigestPhase
+{
+public:
+#ifdef DBWRAP_FB_METRICS
+    /** an Execute phase begins a new call of statement with params */
+    QueryDigestPhase(QueryDigestCall *call, QueryDigestCall::Phase phase,
+                     FbApiHandle statement = 0,
+                     const XSQLDA *params = nullptr) :
+                                    call_(call),
+                                    phase_(phase),
+                                    start_(std::chrono::steady_clock::now()),
+                                    finish_(false),
+                                    failed_(false)
+    {
+        if (call_ && phase == QueryDigestCall::Execute) {
+            call_->begin(statement, params);
+        }
+    }
+
+    ~QueryDigestPhase()
+    {
+        if (!call_) {
+            return;
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        call_->add(phase_, static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        if (finish_ || failed_) {
+            call_->finish(failed_);
+        }
+    }
+
+    void row()
+    {
+        if (call_) {
+            call_->addRow();
+        }
+    }
+
+    /** the call is finished when the phase ends */
+    void finish()
+    {
+        finish_ = true;
+    }
+
+    /** the call failed, it's finished when the phase ends */
+    void fail()
+    {
+        failed_ = true;
+    }
+
+private:
+    QueryDigestCall *call_;
+    QueryDigestCall::Phase phase_;
+    std::chrono::steady_clock::time_point start_;
+    bool finish_;
+    bool failed_;
+#else
+    QueryDigestPhase(QueryDigestCall *, QueryDigestCall::Phase,
+                     FbApiHandle = 0, const XSQLDA * = nullptr)
+    {
+    }
+    void row()
+    {
+    }
+    void finish()
+    {
+    }
+    void fail()
+    {
+    }
+#endif
+};
+
 } /* namespace fb */
 
 #endif /* DBWRAP_FB_FBINTERNALS_H_ */
@@ -12,16 +12,38 @@
  * Public License version 2.1
  */
 #include "DbBlob.h"
+#include "DbBulkLoader.h"
 #include "DbConnection.h"
+#include "DbExporter.h"
+#include "DbInListStatement.h"
+#include "DbKeysetScanner.h"
+#include "DbMetrics.h"
+#include "DbMonitor.h"
+#include "DbParallelScan.h"
+#include "DbPlanWatch.h"
+#include "DbQueryStats.h"
+#include "DbResultRow.h"
+#include "DbRetry.h"
 #include "DbRowProxy.h"
+#include "DbSlowQueryLog.h"
+#include "DbStaging.h"
 #include "DbStatement.h"
 #include "DbTransaction.h"
+#include "DbTransactionWatchdog.h"
+#include "DbWriteQueue.h"
 #include "FbException.h"
 
+#include <ibase.h>
+
 #include <cassert>
+#include <chrono>
 #include <iostream>
 #include <stdexcept>
 #include <cstring>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <unistd.h>
 
 
@@ -413,6 +435,1002 @@ static void execute_procedure_tests()
     trans.commit();
 }
 
+static void retry_transaction_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+
+    DbRetryStats stats;
+    DbRetryOptions options(3, 1, 5, &stats);
+    int attempts = 0;
+
+    runInTransaction(dbc, options, [&](DbTransaction &tr) {
+        ++attempts;
+        dbc.executeUpdate("UPDATE TEST1 SET I64_1 = I64_1 + 1 WHERE IID = 6", &tr);
+        if (attempts == 1) {
+            // simulate the status vector of an update conflict
+            const intptr_t status[] = { isc_arg_gds, isc_deadlock,
+                                        isc_arg_gds, isc_update_conflict,
+                                        isc_arg_end };
+            throw FbException("simulated update conflict", status);
+        }
+    });
+    assert(attempts == 2);
+    assert(stats.retries(RetryableError::UpdateConflict) == 1);
+
+    // the update of the first (rolled back) attempt must not be visible
+    DbStatement st = dbc.createStatement("SELECT I64_1 FROM TEST1 WHERE IID = 6");
+    if (st.uniqueResult().getInt64(0) != 61) {
+        throw std::runtime_error("retried transaction applied its work twice");
+    }
+
+    // non retryable errors are passed to the caller without retrying
+    attempts = 0;
+    try {
+        runInTransaction(dbc, options, [&](DbTransaction &tr) {
+            ++attempts;
+            dbc.executeUpdate("INSERT INTO TEST1 (IID) VALUES (6)", &tr);
+        });
+        throw std::runtime_error("constraint violation should have failed");
+    } catch (FbException &) {
+        assert(attempts == 1);
+    }
+}
+
+static void savepoint_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbTransaction trans(dbc.nativeHandle(), 1);
+
+    dbc.executeUpdate("DELETE FROM TEST1 WHERE IID >= 100", &trans);
+
+    DbStatement st = dbc.createStatement(
+            "INSERT INTO TEST1 (IID, I64_1) VALUES (?, ?)", &trans);
+
+    // the third row violates the primary key, skip it but keep the others
+    const int ids[] = { 100, 101, 101, 102 };
+    int skipped = 0;
+    for (int id : ids) {
+        DbSavepoint sp(trans);
+        try {
+            st.setInt(1, id);
+            st.setInt(2, id * 10);
+            st.execute();
+            sp.release();
+        } catch (FbException &) {
+            ++skipped;
+        }
+    }
+    assert(skipped == 1);
+
+    // undo an update using named savepoints
+    trans.savepoint("BEFORE_UPDATE");
+    dbc.executeUpdate("UPDATE TEST1 SET I64_1 = 0 WHERE IID >= 100", &trans);
+    trans.rollbackTo("BEFORE_UPDATE");
+    trans.releaseSavepoint("BEFORE_UPDATE");
+    trans.commitRetain();
+
+    st = dbc.createStatement(
+            "SELECT COUNT(*), SUM(I64_1) FROM TEST1 WHERE IID >= 100", &trans);
+    DbRowProxy row = st.uniqueResult();
+    if (row.getInt(0) != 3 || row.getInt64(1) != 3030) {
+        throw std::runtime_error("savepoint rollback failure.");
+    }
+}
+
+static void write_queue_tests()
+{
+    DbConnection dbc1(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbConnection dbc2(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbConnection *connections[] = { &dbc1, &dbc2 };
+
+    dbc1.executeUpdate("DELETE FROM TEST1 WHERE IID >= 1000");
+
+    {
+        DbWriteQueue queue(connections, 2, DbWriteQueueOptions(64, 5));
+
+        // several producers, each writing a few rows
+        std::vector<std::thread> producers;
+        for (int t = 0; t != 4; ++t) {
+            producers.emplace_back([&queue, t] {
+                std::vector<std::future<void>> done;
+                for (int i = 0; i != 50; ++i) {
+                    int id = 1000 + t * 50 + i;
+                    done.push_back(queue.enqueue(
+                            "INSERT INTO TEST1 (IID, I64_1, VC5) VALUES (?, ?, ?)",
+                            { id, id * 2, "q" }));
+                }
+                for (auto &f : done) {
+                    f.get();
+                }
+            });
+        }
+        for (auto &p : producers) {
+            p.join();
+        }
+
+        // a failing write fails only its own future
+        std::future<void> dup = queue.enqueue(
+                "INSERT INTO TEST1 (IID) VALUES (?)", { 1000 });
+        std::future<void> ok = queue.enqueue(
+                "INSERT INTO TEST1 (IID) VALUES (?)", { 1200 });
+        try {
+            dup.get();
+            throw std::runtime_error("constraint violation should have failed");
+        } catch (FbException &) {
+        }
+        ok.get();
+
+        queue.flush();
+        assert(queue.committedRows() == 201);
+        printf("write queue committed %llu rows in %llu batches\n",
+               static_cast<unsigned long long>(queue.committedRows()),
+               static_cast<unsigned long long>(queue.committedBatches()));
+    }
+
+    DbStatement st = dbc1.createStatement(
+            "SELECT COUNT(*) FROM TEST1 WHERE IID >= 1000");
+    if (st.uniqueResult().getInt(0) != 201) {
+        throw std::runtime_error("write queue lost rows.");
+    }
+}
+
+static void autocommit_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbConnection observer(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+
+    dbc.setAutoCommit(true);
+    assert(dbc.autoCommit());
+
+    dbc.executeUpdate("DELETE FROM TEST1 WHERE IID BETWEEN 2000 AND 2099");
+    dbc.executeUpdate("INSERT INTO TEST1 (IID, I64_1) VALUES (2000, 1)");
+    {
+        DbStatement st = dbc.createStatement(
+                "INSERT INTO TEST1 (IID, I64_1) VALUES (?, ?)");
+        st.setInt(1, 2001);
+        st.setInt(2, 2);
+        st.execute();
+    }
+
+    // both rows must be visible to another attachment right away
+    DbStatement st = observer.createStatement(
+            "SELECT COUNT(*) FROM TEST1 WHERE IID BETWEEN 2000 AND 2099");
+    if (st.uniqueResult().getInt(0) != 2) {
+        throw std::runtime_error("autocommit mode didn't commit.");
+    }
+
+    dbc.setAutoCommit(false);
+    assert(!dbc.autoCommit());
+}
+
+static void execute_immediate_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbTransaction trans(dbc.nativeHandle(), 1);
+
+    dbc.executeImmediate("DELETE FROM TEST1 WHERE IID >= ?", { 3000 }, &trans);
+    dbc.executeImmediate("INSERT INTO TEST1 (IID, I64_1, VC5) VALUES (?, ?, ?)",
+                         { 3000, 30000, "imm" }, &trans);
+    dbc.executeImmediate("INSERT INTO TEST1 (IID, I64_1, VC5) VALUES (?, ?, ?)",
+                         { 3001, nullptr, nullptr }, &trans);
+
+    DbResultRow r = dbc.executeImmediateRow(
+            "INSERT INTO TEST1 (IID, I64_1) VALUES (?, ?) RETURNING IID, TS",
+            2, { 3002, 5 }, &trans);
+    if (!r || r.row().getInt(0) != 3002) {
+        throw std::runtime_error("executeImmediateRow RETURNING failure.");
+    }
+    printf("inserted 3002 at %s\n", r.row().getText(1).c_str());
+
+    r = dbc.executeImmediateRow(
+            "SELECT I64_1, VC5 FROM TEST1 WHERE IID = ?", 2, { 3000 }, &trans);
+    if (!r || r.row().getInt64(0) != 30000 || r.row().getText(1) != "imm") {
+        throw std::runtime_error("executeImmediateRow SELECT failure.");
+    }
+
+    r = dbc.executeImmediateRow(
+            "SELECT I64_1, VC5 FROM TEST1 WHERE IID = ?", 2, { 3001 }, &trans);
+    if (!r || !r.row().fieldIsNull(0) || !r.row().fieldIsNull(1)) {
+        throw std::runtime_error("executeImmediateRow null value failure.");
+    }
+
+    r = dbc.executeImmediateRow(
+            "SELECT IID FROM TEST1 WHERE IID = ?", 1, { -1 }, &trans);
+    if (r) {
+        throw std::runtime_error("executeImmediateRow returned a missing row.");
+    }
+    trans.commit();
+}
+
+static void singleton_select_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbTransaction trans(dbc.nativeHandle(), 1);
+
+    DbStatement st = dbc.createStatement(
+            "SELECT IID, I64_1 FROM TEST1 WHERE IID = ?", &trans);
+    st.setSingleton();
+
+    st.setInt(1, 7);
+    DbRowProxy row = st.uniqueResult();
+    if (!row || row.getInt(0) != 7 || row.getInt64(1) != 70) {
+        throw std::runtime_error("singleton select failure.");
+    }
+
+    // no cursor is opened, the statement can be executed again right away
+    st.setInt(1, -1);
+    if (st.uniqueResult()) {
+        throw std::runtime_error("singleton select returned a missing row.");
+    }
+
+    st = dbc.createStatement("SELECT IID FROM TEST1", &trans);
+    st.setSingleton();
+    try {
+        st.uniqueResult();
+        throw std::runtime_error("singleton select of many rows should have failed");
+    } catch (FbException &exc) {
+        assert(exc.hasErrorCode(isc_sing_select_err));
+    }
+}
+
+static void named_parameters_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbTransaction trans(dbc.nativeHandle(), 1);
+
+    DbStatement st = dbc.createNamedStatement(
+            "SELECT r.IID, r.I64_1 AS amount, ':not_a_param' AS lit "
+            "FROM TEST1 r "
+            "WHERE r.IID BETWEEN :lo AND :hi OR r.IID = :lo -- :comment\n"
+            "ORDER BY r.IID", &trans);
+    st.setInt("lo", 6);
+    st.setInt("hi", 7);
+
+    int count = 0;
+    for (DbStatement::Iterator i = st.iterate(); i != st.end(); ++i) {
+        DbRowProxy row = *i;
+        unsigned int amount = row.columnIndex("amount");
+        assert(amount == 1);
+        assert(row.columnIndex("IID") == 0);
+        assert(row.getText(row.columnIndex("LIT")) == ":not_a_param");
+        printf("IID %d amount %lld\n", row.getInt(row.columnIndex("iid")),
+               static_cast<long long>(row.getInt64(amount)));
+        ++count;
+    }
+    assert(count == 2);
+
+    try {
+        st.setInt("missing", 1);
+        throw std::runtime_error("unknown parameter name should have failed");
+    } catch (std::out_of_range &) {
+    }
+}
+
+static int count_rows(DbStatement &st)
+{
+    int count = 0;
+    for (DbStatement::Iterator i = st.iterate(); i != st.end(); ++i) {
+        ++count;
+    }
+    return count;
+}
+
+static void in_list_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbTransaction trans(dbc.nativeHandle(), 1);
+
+    // TEST1 holds the rows 6, 7, 8 and some rows >= 100
+    DbInListStatement q(dbc, trans,
+            "SELECT IID FROM TEST1 WHERE IID IN (?...) AND IID < ?", 8);
+    q.setParam(1, 1000);
+
+    q.setList(std::vector<int64_t>());
+    assert(count_rows(q.bind()) == 0);
+
+    q.setList(std::vector<int64_t>{ 6, 7, 8 });
+    assert(count_rows(q.bind()) == 3);
+
+    q.setList(std::vector<int64_t>{ 6, 8, -1, -2, -3 });
+    assert(count_rows(q.bind()) == 2);
+
+    // more values than maxInlineValues go through a temporary table
+    std::vector<int64_t> many;
+    for (int64_t i = -100; i != 9; ++i) {
+        many.push_back(i);
+    }
+    q.setList(many);
+    assert(count_rows(q.bind()) == 3);
+
+    DbInListStatement t(dbc, trans,
+            "SELECT IID FROM TEST1 WHERE VC5 IN (?...)", 2);
+    t.setList(std::vector<std::string>{ "sixty", "seven" });
+    assert(count_rows(t.bind()) == 2);
+    t.setList(std::vector<std::string>{ "sixty", "seven", "nope" });
+    assert(count_rows(t.bind()) == 2);
+}
+
+static void staging_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbTransaction trans(dbc.nativeHandle(), 1);
+
+    DbStaging keys(dbc, trans, "K BIGINT, LABEL VARCHAR(20)");
+    assert(keys.columnCount() == 2);
+    for (int i = 0; i != 1000; ++i) {
+        keys.add(i, "key");
+    }
+    assert(keys.rowCount() == 1000);
+
+    std::string sql = "SELECT COUNT(*) FROM TEST1 t JOIN ";
+    sql += keys.tableName();
+    sql += " k ON k.K = t.IID";
+    DbStatement st = dbc.createStatement(sql.c_str(), &trans);
+    int joined = st.uniqueResult().getInt(0);
+    printf("%d rows joined with %s\n", joined, keys.tableName());
+    assert(joined > 0);
+
+    // equivalent column definitions share the same table
+    DbStaging same(dbc, trans, "k   bigint,  label varchar(20) ");
+    assert(strcmp(same.tableName(), keys.tableName()) == 0);
+
+    // staged rows are gone after commit
+    trans.commit();
+    trans.start();
+    sql = "SELECT COUNT(*) FROM ";
+    sql += keys.tableName();
+    st = dbc.createStatement(sql.c_str(), &trans);
+    assert(st.uniqueResult().getInt(0) == 0);
+}
+
+static void keyset_scanner_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+
+    DbStatement st = dbc.createStatement("SELECT COUNT(*), MAX(IID) FROM TEST1");
+    DbRowProxy totals = st.uniqueResult();
+    const int total = totals.getInt(0);
+    const int64_t maxKey = totals.getInt64(1);
+    st.close();
+
+    DbKeysetScanner scanner(dbc, "TEST1", "IID", "I64_1, VC5", 7);
+    int rows = 0;
+    int64_t previous = -1;
+    while (scanner.next()) {
+        int64_t key = scanner.row().getInt64(0);
+        assert(key > previous);
+        previous = key;
+        ++rows;
+    }
+    printf("keyset scan read %d rows in %d chunks\n", rows,
+           static_cast<int>(scanner.chunkCount()));
+    assert(rows == total);
+    assert(scanner.chunkCount() == static_cast<uint64_t>(total / 7 + 1));
+    assert(scanner.hasCheckpoint() && scanner.checkpoint() == maxKey);
+
+    // resume after a checkpoint, reading all the columns
+    DbKeysetScanner resumed(dbc, "TEST1", "IID", "*", 3);
+    resumed.resumeAfter(maxKey - 1);
+    assert(resumed.next());
+    assert(resumed.row().getInt64(0) == maxKey);
+    assert(resumed.row().columnCount() > 2);
+    assert(!resumed.next());
+    assert(!resumed.next());
+}
+
+static void parallel_scan_tests()
+{
+    DbConnection dbc1(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbConnection dbc2(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbConnection dbc3(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbConnection *connections[] = { &dbc1, &dbc2, &dbc3 };
+
+    DbStatement st = dbc1.createStatement("SELECT COUNT(*), SUM(IID) FROM TEST1");
+    DbRowProxy totals = st.uniqueResult();
+    const int total = totals.getInt(0);
+    const int64_t keySum = totals.getInt64(1);
+    st.close();
+
+    DbParallelScan unordered(connections, 3, "TEST1", "IID", "I64_1, VC5",
+                             DbParallelScanOptions(false, 4, 2));
+    int64_t sum = 0;
+    uint64_t rows = unordered.run([&sum](const DbRowProxy &row) {
+        sum += row.getInt64(0);
+    });
+    printf("parallel scan read %d rows\n", static_cast<int>(rows));
+    assert(rows == static_cast<uint64_t>(total));
+    assert(sum == keySum);
+
+    DbParallelScan ordered(connections, 3, "TEST1", "IID", "*",
+                           DbParallelScanOptions(true, 4, 2));
+    int64_t previous = -1;
+    rows = ordered.run([&previous](const DbRowProxy &row) {
+        assert(row.columnCount() > 2);
+        assert(row.getInt64(0) > previous);
+        previous = row.getInt64(0);
+    });
+    assert(rows == static_cast<uint64_t>(total));
+
+    // an exception thrown by the callback stops the scan
+    bool stopped = false;
+    try {
+        ordered.run([](const DbRowProxy &) {
+            throw std::runtime_error("stop");
+        });
+    } catch (std::runtime_error &) {
+        stopped = true;
+    }
+    assert(stopped);
+}
+
+static void shared_snapshot_tests()
+{
+    DbConnection dbc1(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbConnection dbc2(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    dbc2.executeUpdate("DELETE FROM TEST1 WHERE IID = 4000");
+
+    DbTransaction snapshot(dbc1.nativeHandle(), 1,
+                           DefaultTransMode::Commit,
+                           TransStartMode::DeferStart);
+    snapshot.startSnapshot();
+    DbStatement st = dbc1.createStatement("SELECT COUNT(*) FROM TEST1", &snapshot);
+    const int before = st.uniqueResult().getInt(0);
+    st.reset();
+
+    // a row committed after the snapshot started is not seen by it
+    dbc2.executeUpdate("INSERT INTO TEST1 (IID, I64_1) VALUES (4000, 1)");
+    assert(st.uniqueResult().getInt(0) == before);
+    st.reset();
+
+    int64_t number = 0;
+    try {
+        number = snapshot.snapshotNumber();
+    } catch (std::exception &exc) {
+        // FbException from a server before Firebird 4, std::logic_error
+        // if the client library is older
+        printf("shared snapshots are not supported: %s\n", exc.what());
+        return;
+    }
+    printf("snapshot number: %lld\n", static_cast<long long>(number));
+
+    DbTransaction same(dbc2.nativeHandle(), 1,
+                       DefaultTransMode::Commit,
+                       TransStartMode::DeferStart);
+    same.startAtSnapshot(number);
+    assert(same.snapshotNumber() == number);
+    DbStatement st2 = dbc2.createStatement("SELECT COUNT(*) FROM TEST1", &same);
+    assert(st2.uniqueResult().getInt(0) == before);
+    st2.reset();
+
+    // a parallel scan of the same snapshot
+    DbConnection *connections[] = { &dbc2 };
+    DbParallelScan scan(connections, 1, "TEST1", "IID", "I64_1",
+                        DbParallelScanOptions(false, 256, 16, number));
+    uint64_t rows = scan.run([](const DbRowProxy &) {});
+    assert(rows == static_cast<uint64_t>(before));
+}
+
+static void bulk_loader_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbTransaction trans(dbc.nativeHandle(), 1);
+    drop_table_if_exists(dbc, trans, "BULK1");
+    dbc.executeUpdate(
+            "CREATE TABLE BULK1 ("
+                "ID     INTEGER NOT NULL, "
+                "AMOUNT NUMERIC(10, 2), "
+                "NAME   VARCHAR(20), "
+                "D      DATE, "
+                "TS     TIMESTAMP, "
+                "CONSTRAINT PK_BULK1 PRIMARY KEY (ID))", &trans);
+    trans.commitRetain();
+
+    const char *fileName = "DbWrap++FBBulkLoad.csv";
+    const char *rejectName = "DbWrap++FBBulkLoad.rejects";
+    FILE *f = fopen(fileName, "wb");
+    assert(f);
+    fprintf(f, "ID,AMOUNT,NAME,D,TS\n");
+    fprintf(f, "1,10.50,\"Smith, John\",2024-01-31,2024-01-31 12:30:00.5\r\n");
+    fprintf(f, "2,-3,plain,,\n");
+    fprintf(f, "3,abc,bad number,,\n");
+    fprintf(f, "1,1,duplicate key,,\n");
+    for (int i = 10; i != 1010; ++i) {
+        fprintf(f, "%d,1.25,row %d,2020-02-29,\n", i, i);
+    }
+    fclose(f);
+
+    DbBulkLoadOptions opts(',', true);
+    opts.parserThreads_ = 3;
+    opts.commitRows_ = 100;
+    opts.batchRows_ = 64;
+    opts.rejectFile_ = rejectName;
+    opts.progressIntervalMs_ = 0;
+    int reports = 0;
+    opts.onProgress_ = [&reports](const DbBulkLoadProgress &) { ++reports; };
+
+    DbBulkLoader loader(dbc, "BULK1", "ID, AMOUNT, NAME, D, TS", opts);
+    DbBulkLoadProgress result = loader.load(fileName);
+    printf("bulk load: %d rows loaded, %d rejected, %.0f rows/s\n",
+           static_cast<int>(result.rowsLoaded_),
+           static_cast<int>(result.rowsRejected_), result.rowsPerSecond_);
+    assert(result.rowsLoaded_ == 1002);
+    assert(result.rowsRejected_ == 2);
+    assert(result.bytesRead_ == result.bytesTotal_);
+    assert(reports > 0);
+
+    DbStatement st = dbc.createStatement(
+            "SELECT COUNT(*), CAST(SUM(AMOUNT) * 100 AS BIGINT) FROM BULK1", &trans);
+    DbRowProxy totals = st.uniqueResult();
+    assert(totals.getInt(0) == 1002);
+    assert(totals.getInt64(1) == 1050 - 300 + 1000 * 125);
+    st.reset();
+
+    st = dbc.createStatement("SELECT NAME FROM BULK1 WHERE ID = 1", &trans);
+    assert(st.uniqueResult().getText(0) == "Smith, John");
+    st.reset();
+
+    // without a reject file a bad row stops the load
+    DbBulkLoader strict(dbc, "BULK1", "ID, AMOUNT, NAME, D, TS",
+                        DbBulkLoadOptions(',', true));
+    bool failed = false;
+    try {
+        strict.load(fileName);
+    } catch (std::exception &) {
+        failed = true;
+    }
+    assert(failed);
+
+    // the same file through an external table, the server must be local
+    // and allowed to read external files in the current directory
+    dbc.executeUpdate("DELETE FROM BULK1", &trans);
+    trans.commitRetain();
+
+    char externalName[4096] = "";
+    if (!getcwd(externalName, sizeof(externalName) - 32)) {
+        externalName[0] = '\0';
+    }
+    strcat(externalName, "/DbWrap++FBBulkLoad.dat");
+    try {
+        result = loader.loadExternal(fileName, externalName);
+        printf("external table load: %d rows loaded, %d rejected\n",
+               static_cast<int>(result.rowsLoaded_),
+               static_cast<int>(result.rowsRejected_));
+        // the duplicate key fails the single INSERT, see below
+        assert(false);
+    } catch (FbException &exc) {
+        printf("external table load failed: %s\n", exc.what());
+    }
+    assert(access(externalName, F_OK) != 0);
+
+    // without the duplicate key row
+    f = fopen(fileName, "wb");
+    assert(f);
+    fprintf(f, "1,10.50,\"Smith, John\",2024-01-31,2024-01-31 12:30:00.5\n");
+    fprintf(f, "2,-3,,,\n");
+    fprintf(f, "3,abc,bad number,,\n");
+    fclose(f);
+
+    DbBulkLoadOptions externalOpts;
+    externalOpts.rejectFile_ = rejectName;
+    DbBulkLoader externalLoader(dbc, "BULK1", "ID, AMOUNT, NAME, D, TS",
+                                externalOpts);
+    try {
+        result = externalLoader.loadExternal(fileName, externalName);
+        assert(result.rowsLoaded_ == 2 && result.rowsRejected_ == 1);
+
+        st = dbc.createStatement("SELECT CAST(SUM(AMOUNT) * 100 AS BIGINT), "
+                                 "COUNT(NAME) FROM BULK1", &trans);
+        totals = st.uniqueResult();
+        assert(totals.getInt64(0) == 1050 - 300);
+        assert(totals.getInt(1) == 1);
+        st.reset();
+    } catch (FbException &exc) {
+        printf("external tables are not available: %s\n", exc.what());
+    }
+
+    unlink(fileName);
+    unlink(rejectName);
+}
+
+static std::string read_file(const char *fileName)
+{
+    std::string content;
+    FILE *f = fopen(fileName, "rb");
+    assert(f);
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) != 0) {
+        content.append(buffer, n);
+    }
+    fclose(f);
+    return content;
+}
+
+static void exporter_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbTransaction trans(dbc.nativeHandle(), 1);
+    dbc.executeUpdate("DELETE FROM BULK1", &trans);
+    dbc.executeUpdate("INSERT INTO BULK1 (ID, AMOUNT, NAME, D, TS) VALUES "
+                      "(1, -0.05, 'say \"hi\", bye', '2024-01-31', "
+                      "'2024-01-31 12:30:00.5')", &trans);
+    dbc.executeUpdate("INSERT INTO BULK1 (ID, AMOUNT, NAME) VALUES "
+                      "(2, 1234.50, '')", &trans);
+    dbc.executeUpdate("INSERT INTO BULK1 (ID) VALUES (3)", &trans);
+    trans.commitRetain();
+
+    const char *sql = "SELECT ID, AMOUNT, NAME, D, TS FROM BULK1 ORDER BY ID";
+    const char *csvName = "DbWrap++FBExport.csv";
+    DbExportOptions csvOpts;
+    csvOpts.header_ = true;
+    DbExporter csv(csvOpts);
+    assert(csv.exportQuery(dbc, sql, csvName, &trans) == 3);
+
+    std::string content = read_file(csvName);
+    printf("exported CSV:\n%s", content.c_str());
+    assert(content ==
+           "ID,AMOUNT,NAME,D,TS\n"
+           "1,-0.05,\"say \"\"hi\"\", bye\",2024-01-31,2024-01-31 12:30:00.5000\n"
+           "2,1234.50,\"\",,\n"
+           "3,,,,\n");
+
+    // the exported CSV loads back
+    dbc.executeUpdate("DELETE FROM BULK1", &trans);
+    trans.commitRetain();
+    DbBulkLoader csvLoader(dbc, "BULK1", "ID, AMOUNT, NAME, D, TS",
+                           DbBulkLoadOptions(',', true));
+    assert(csvLoader.load(csvName).rowsLoaded_ == 3);
+    unlink(csvName);
+
+    // binary rows, exported and loaded back
+    const char *binName = "DbWrap++FBExport.bin";
+    DbExporter binary(DbExportOptions(DbExportFormat::Binary));
+    assert(binary.exportQuery(dbc, sql, binName, &trans) == 3);
+    dbc.executeUpdate("DELETE FROM BULK1", &trans);
+    trans.commitRetain();
+
+    DbBulkLoader binLoader(dbc, "BULK1", "ID, AMOUNT, NAME, D, TS");
+    DbBulkLoadProgress result = binLoader.loadBinary(binName);
+    assert(result.rowsLoaded_ == 3 && result.rowsRejected_ == 0);
+    unlink(binName);
+
+    const char *textName = "DbWrap++FBExport2.csv";
+    assert(csv.exportQuery(dbc, sql, textName, &trans) == 3);
+    assert(read_file(textName) == content);
+    unlink(textName);
+
+    // a consistent dump of two tables on two connections
+    DbConnection dbc2(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbConnection *connections[] = { &dbc, &dbc2 };
+    std::vector<std::string> tables = { "BULK1", "TEST1" };
+    uint64_t rows = binary.dumpTables(connections, 2, tables, ".");
+    printf("dumped %d rows\n", static_cast<int>(rows));
+    assert(rows >= 3);
+    assert(access("./BULK1.bin", F_OK) == 0 && access("./TEST1.bin", F_OK) == 0);
+    unlink("./BULK1.bin");
+    unlink("./TEST1.bin");
+
+    // the file names can't leave the directory, "../T" is dumped to "___T"
+    std::vector<std::string> clashing = { "../T", "__/T" };
+    try {
+        binary.dumpTables(connections, 2, clashing, ".");
+        assert(false);
+    } catch (std::invalid_argument &) {
+    }
+}
+
+static void metrics_tests()
+{
+    DbMetricsSnapshot snap = DbMetricsSnapshot::take();
+    const DbOperation recorded[] = {
+        DbOperation::Prepare, DbOperation::Execute, DbOperation::Fetch,
+        DbOperation::TransactionStart, DbOperation::Commit,
+        DbOperation::BlobRead, DbOperation::BlobWrite
+    };
+
+    for (DbOperation op : recorded) {
+        const DbLatencySummary &s = snap[op];
+        if (!DbMetricsSnapshot::enabled()) {
+            assert(s.count_ == 0);
+            continue;
+        }
+        assert(s.count_ > 0);
+        assert(s.p50Ns_ <= s.p99Ns_ && s.p99Ns_ <= s.p999Ns_ && s.p999Ns_ <= s.maxNs_);
+        printf("%s: %llu calls, p50 %lluns, p99 %lluns\n", operationName(op),
+               static_cast<unsigned long long>(s.count_),
+               static_cast<unsigned long long>(s.p50Ns_),
+               static_cast<unsigned long long>(s.p99Ns_));
+    }
+
+    std::string text = snap.prometheusText();
+    assert(text.find("# TYPE dbwrap_fb_operation_seconds summary\n") != std::string::npos);
+    assert(text.find("dbwrap_fb_operation_seconds_count{operation=\"fetch\"}") !=
+           std::string::npos);
+}
+
+static void query_stats_tests()
+{
+    assert(DbQueryStats::normalize(
+                "select  *\n from T1 -- comment\n where ID = 12 and "
+                "NAME = 'it''s' and X < 1.5e-3 and \"quoted\" = 0") ==
+           "SELECT * FROM T1 WHERE ID = ? AND NAME = ? AND X < ? AND \"quoted\" = ?");
+    assert(DbQueryStats::normalize("SELECT ID FROM T1 WHERE ID IN (1,2)") ==
+           DbQueryStats::normalize("select id from t1 where id in (3, 4)"));
+    // the spacing around punctuation and operators doesn't matter
+    assert(DbQueryStats::normalize("SELECT COUNT(*),T1.ID FROM T1 WHERE ID>=-1 "
+                                   "AND X IN(1,2)") ==
+           "SELECT COUNT (*), T1.ID FROM T1 WHERE ID >= - ? AND X IN (?, ?)");
+    assert(DbQueryStats::normalize("select count( * ) , t1 . id from t1 where "
+                                   "id >= - 1 and x in ( 3 ,4 )") ==
+           "SELECT COUNT (*), T1.ID FROM T1 WHERE ID >= - ? AND X IN (?, ?)");
+    assert(DbQueryStats::normalize("SELECT A||'x' FROM T1 WHERE B<>2") ==
+           "SELECT A || ? FROM T1 WHERE B <> ?");
+
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbTransaction trans(dbc.nativeHandle(), 1);
+    DbQueryStats::reset();
+
+    for (int i = 0; i != 3; ++i) {
+        std::string sql = "SELECT ID FROM BULK1 WHERE ID > " + std::to_string(i);
+        DbStatement st = dbc.createStatement(sql.c_str(), &trans);
+        for (auto row = st.iterate(); row != st.end(); ++row) {
+        }
+    }
+    try {
+        dbc.executeUpdate("UPDATE NO_SUCH_TABLE SET X = 1", &trans);
+    } catch (FbException &) {
+    }
+
+    std::vector<DbQueryDigestStats> top = DbQueryStats::top(10);
+    if (!DbMetricsSnapshot::enabled()) {
+        assert(top.empty());
+        return;
+    }
+
+    bool found = false;
+    for (const auto &s : top) {
+        printf("%s: %d calls, %d rows, %d errors, %lluns\n", s.digest_.c_str(),
+               static_cast<int>(s.calls_), static_cast<int>(s.rows_),
+               static_cast<int>(s.errors_),
+               static_cast<unsigned long long>(s.totalNs_));
+        if (s.digest_ == "SELECT ID FROM BULK1 WHERE ID > ?") {
+            assert(s.calls_ == 3 && s.errors_ == 0);
+            assert(s.minNs_ <= s.maxNs_ && s.maxNs_ <= s.totalNs_);
+            found = true;
+        } else if (s.digest_ == "UPDATE NO_SUCH_TABLE SET X = ?") {
+            assert(s.calls_ == 1 && s.errors_ == 1);
+        }
+    }
+    assert(found);
+}
+
+static void slow_query_log_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbTransaction trans(dbc.nativeHandle(), 1);
+
+    DbStatement st = dbc.createStatement(
+            "SELECT ID, NAME FROM BULK1 WHERE ID > ? AND NAME <> ?", &trans);
+    std::string plan = st.plan();
+    printf("plan: %s\n", plan.c_str());
+    assert(plan.compare(0, 4, "PLAN") == 0);
+
+    std::vector<DbSlowQuery> logged;
+    std::mutex loggedMutex;
+    // a zero threshold reports every call
+    DbSlowQueryLog::setSink([&](const DbSlowQuery &q) {
+        std::lock_guard<std::mutex> const lg(loggedMutex);
+        logged.push_back(q);
+    }, 0);
+
+    st.setInt(1, 0);
+    st.setText(2, "it's");
+    int rows = 0;
+    for (auto row = st.iterate(); row != st.end(); ++row) {
+        ++rows;
+    }
+    st.reset();
+    DbSlowQueryLog::setSink(nullptr, 0);
+
+    if (!DbMetricsSnapshot::enabled()) {
+        assert(logged.empty());
+        return;
+    }
+
+    assert(logged.size() == 1);
+    const DbSlowQuery &q = logged[0];
+    printf("%s", q.describe().c_str());
+    assert(q.rows_ == static_cast<uint64_t>(rows) && !q.failed_);
+    assert(q.params_.size() == 2 && q.params_[0] == "0" && q.params_[1] == "'it''s'");
+    assert(q.plan_ == plan);
+}
+
+static void plan_watch_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    const char *sql = "SELECT ID FROM BULK1 WHERE NAME = 'x'";
+
+    std::vector<DbPlanChange> changes;
+    std::mutex changesMutex;
+    DbPlanWatch::enable([&](const DbPlanChange &c) {
+        std::lock_guard<std::mutex> const lg(changesMutex);
+        changes.push_back(c);
+    });
+    const uint64_t before = DbPlanWatch::changeCount();
+
+    dbc.executeUpdate("CREATE INDEX IDX_BULK1_NAME ON BULK1 (NAME)");
+    {
+        DbTransaction trans(dbc.nativeHandle(), 1);
+        DbStatement st = dbc.createStatement(sql, &trans);
+        DbStatement again = dbc.createStatement(sql, &trans);
+    }
+    assert(DbPlanWatch::changeCount() == before);
+
+    dbc.executeUpdate("DROP INDEX IDX_BULK1_NAME");
+    {
+        DbTransaction trans(dbc.nativeHandle(), 1);
+        // a different literal has the same digest
+        DbStatement st = dbc.createStatement(
+                "SELECT ID FROM BULK1 WHERE NAME = 'y'", &trans);
+    }
+    DbPlanWatch::disable();
+
+    assert(DbPlanWatch::changeCount() == before + 1);
+    assert(changes.size() == 1);
+    printf("plan change of %s:\n  %s\n  %s\n", changes[0].digest_.c_str(),
+           changes[0].previousPlan_.c_str(), changes[0].plan_.c_str());
+    assert(changes[0].previousPlan_.find("IDX_BULK1_NAME") != std::string::npos);
+    assert(changes[0].plan_.find("NATURAL") != std::string::npos);
+}
+
+static void execution_stats_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbTransaction trans(dbc.nativeHandle(), 1);
+
+    DbStatement scan = dbc.createStatement("SELECT ID FROM BULK1", &trans);
+    scan.setCollectStats();
+    uint64_t rows = 0;
+    for (auto row = scan.iterate(); row != scan.end(); ++row) {
+        ++rows;
+    }
+    DbExecutionStats stats = scan.executionStats();
+    printf("scan: %d selected, %d fetches, %d sequential reads\n",
+           static_cast<int>(stats.selected_),
+           static_cast<int>(stats.pageFetches_),
+           static_cast<int>(stats.sequentialReads()));
+    assert(stats.selected_ == rows);
+    assert(stats.sequentialReads() >= rows && stats.pageFetches_ > 0);
+    bool found = false;
+    for (const auto &t : stats.tables_) {
+        found = found || (t.table_ == "BULK1" && t.sequential_ >= rows);
+    }
+    assert(found);
+
+    DbStatement update = dbc.createStatement(
+            "UPDATE BULK1 SET NAME = NAME WHERE ID = 1", &trans);
+    update.setCollectStats();
+    update.execute();
+    stats = update.executionStats();
+    assert(stats.updated_ == (rows ? 1u : 0u));
+    assert(stats.sequentialReads() == 0);
+
+    DbStatement plain = dbc.createStatement("SELECT ID FROM BULK1", &trans);
+    try {
+        plain.executionStats();
+        assert(false);
+    } catch (std::logic_error &) {
+    }
+}
+
+static void monitor_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbConnection busy(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbMonitor monitor(dbc);
+
+    DbMonSnapshot before;
+    DbMonSnapshot after;
+    monitor.snapshot(before);
+    assert(before.attachments_.size() >= 2);
+    assert(!before.transactions_.empty() && !before.statements_.empty());
+    for (size_t i = 1; i < before.attachments_.size(); ++i) {
+        assert(before.attachments_[i - 1].id_ < before.attachments_[i].id_);
+    }
+
+    // some reads on the other attachment
+    DbTransaction trans(busy.nativeHandle(), 1);
+    for (int i = 0; i != 10; ++i) {
+        DbStatement st = busy.createStatement("SELECT ID FROM BULK1", &trans);
+        for (auto row = st.iterate(); row != st.end(); ++row) {
+        }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    monitor.snapshot(after);
+
+    DbMonRates rates;
+    DbMonitor::diff(before, after, rates);
+    assert(rates.seconds_ > 0 && !rates.attachments_.empty());
+    double fetches = 0;
+    for (const auto &r : rates.attachments_) {
+        fetches += r.pageFetches_;
+    }
+    printf("monitored %d attachments, %d statements, %.0f page fetches/s\n",
+           static_cast<int>(after.attachments_.size()),
+           static_cast<int>(after.statements_.size()), fetches);
+    assert(fetches > 0);
+
+    // polling again reuses the vectors
+    const size_t capacity = before.attachments_.capacity();
+    const DbMonAttachment *data = before.attachments_.data();
+    monitor.snapshot(before);
+    assert(before.attachments_.size() > capacity ||
+           before.attachments_.data() == data);
+}
+
+static void transaction_watchdog_tests()
+{
+    DbConnection dbc(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+
+    std::mutex mutex;
+    std::vector<DbOpenTransaction> reported;
+    DbTransactionWatchdogOptions opts(60000, 1, 0, true);
+    DbTransactionWatchdog watchdog(dbc,
+            [&](const DbOpenTransaction &t) {
+                std::lock_guard<std::mutex> const lg(mutex);
+                reported.push_back(t);
+            },
+            nullptr, opts);
+
+    DbConnection other(g_dbName, g_dbServer, g_dbUserName, DB_PASSWORD);
+    DbTransaction trans(other.nativeHandle(), 1, DefaultTransMode::Commit,
+                        TransStartMode::DeferStart);
+    trans.setTag("watchdog test");
+    trans.start(true);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    watchdog.check();
+    // reported once only
+    watchdog.check();
+    {
+        std::lock_guard<std::mutex> const lg(mutex);
+        assert(reported.size() == 1);
+        assert(reported[0].tag_ == "watchdog test");
+        assert(reported[0].owner_ == std::this_thread::get_id());
+        assert(reported[0].ageMs_ >= 1 && !reported[0].stack_.empty());
+    }
+
+    auto open = DbTransactionWatchdog::openTransactions();
+    assert(open.size() == 1 && open[0].tag_ == "watchdog test");
+
+    trans.commitRetain();
+    assert(DbTransactionWatchdog::openTransactions().size() == 1);
+    trans.commit();
+    assert(DbTransactionWatchdog::openTransactions().empty());
+
+    // the oldest interesting transaction is at most the first of three
+    // active ones and the next transaction number (the last one given
+    // out) at least the third, a maximum gap of 1 is exceeded whatever
+    // the earlier tests left behind, and reported once while it lasts
+    int gaps = 0;
+    DbTransactionWatchdog gapWatch(dbc, nullptr,
+            [&](const DbTransactionGap &gap) {
+                assert(gap.next_ > 0 && gap.next_ >= gap.oldestInteresting_);
+                ++gaps;
+            },
+            DbTransactionWatchdogOptions(60000, 0, 1));
+    DbTransaction busy(other.nativeHandle(), 1);
+    DbTransaction busy2(other.nativeHandle(), 1);
+    DbTransaction busy3(other.nativeHandle(), 1);
+    gapWatch.check();
+    gapWatch.check();
+    busy3.commit();
+    busy2.commit();
+    busy.commit();
+    assert(gaps == 1);
+}
+
 static void event_callback(void *data, const char *eventName, int eventCount)
 {
     int *counter = static_cast<int*>(data);
@@ -491,6 +1509,27 @@ int main (int argc, char *argv[]) try
     blob_tests();
     print_all_datatypes();
     execute_procedure_tests();
+    retry_transaction_tests();
+    savepoint_tests();
+    write_queue_tests();
+    autocommit_tests();
+    execute_immediate_tests();
+    singleton_select_tests();
+    named_parameters_tests();
+    in_list_tests();
+    staging_tests();
+    keyset_scanner_tests();
+    parallel_scan_tests();
+    shared_snapshot_tests();
+    bulk_loader_tests();
+    exporter_tests();
+    metrics_tests();
+    query_stats_tests();
+    slow_query_log_tests();
+    plan_watch_tests();
+    execution_stats_tests();
+    monitor_tests();
+    transaction_watchdog_tests();
     test_events();
     std::cout << "Firebird API Test completed successfully.\n";
 